@@ -0,0 +1,57 @@
+#include <stdlib.h> // For dynamic memory allocation
+#include <string.h> // For memset
+#include "arena.h"
+
+
+// Function to set up an empty arena
+void arenaInit(Arena* arena) {
+    arena->blocks = NULL;
+    arena->next_block_size = ARENA_INITIAL_BLOCK_SIZE;
+    arena->allocated = 0;
+    arena->reserved = 0;
+}
+
+// Function to hand out memory from the current block, adding a block when it is full
+void* arenaAlloc(Arena* arena, size_t size) {
+    size = (size + ARENA_ALIGNMENT - 1) & ~(size_t)(ARENA_ALIGNMENT - 1);
+
+    ArenaBlock* block = arena->blocks;
+    if (block == NULL || block->size - block->used < size) {
+        // The rest of a full block is left unused; the next block doubles, and is large enough for the request
+        size_t blockSize = arena->next_block_size;
+        while (blockSize - sizeof(ArenaBlock) < size) blockSize *= 2;
+        block = malloc(blockSize);
+        if (block == NULL) return NULL;
+
+        block->next = arena->blocks;
+        block->size = blockSize - sizeof(ArenaBlock);
+        block->used = 0;
+        block->mapped = false;
+        arena->blocks = block;
+        arena->reserved += blockSize;
+        if (arena->next_block_size < ARENA_MAX_BLOCK_SIZE) arena->next_block_size *= 2;
+    }
+
+    void* memory = block->data + block->used;
+    block->used += size;
+    arena->allocated += size;
+    return memory;
+}
+
+// Function to hand out zeroed memory from the arena
+void* arenaCalloc(Arena* arena, size_t size) {
+    void* memory = arenaAlloc(arena, size);
+    if (memory != NULL) memset(memory, 0, size);
+    return memory;
+}
+
+// Function to free every block of the arena
+void arenaRelease(Arena* arena) {
+    ArenaBlock* block = arena->blocks;
+    arenaInit(arena); // The arena may live in one of its own blocks, so reset it before freeing them
+    while (block != NULL) {
+        ArenaBlock* next = block->next;
+        if (!block->mapped) free(block);
+        block = next;
+    }
+}
@@ -0,0 +1,72 @@
+#include <stddef.h> // For size_t
+#include <stdbool.h> // For bool type
+
+#ifndef ARENA_H
+#define ARENA_H
+
+// Size of the first block of an arena, and the size blocks stop doubling at
+#define ARENA_INITIAL_BLOCK_SIZE (64 * 1024)
+#define ARENA_MAX_BLOCK_SIZE (4 * 1024 * 1024)
+
+// Allocations are aligned to this many bytes
+#define ARENA_ALIGNMENT 16
+
+// Define the ArenaBlock structure, one malloc'ed region of an arena; allocations are carved from data
+typedef struct ArenaBlock {
+    struct ArenaBlock* next;    // Previously filled block
+    size_t size;                // Bytes in data
+    size_t used;                // Bytes of data handed out
+    bool mapped;                // The block lives in a loaded state image (see snapshot.h), not in memory from malloc
+    _Alignas(ARENA_ALIGNMENT) unsigned char data[];
+} ArenaBlock;
+
+/**
+ * Define the Arena structure, a region allocator: memory is handed out by bumping a pointer through blocks that
+ * double in size (up to ARENA_MAX_BLOCK_SIZE), individual allocations are never freed, and releasing the arena
+ * frees every block at once. Each process keeps its page table metadata in an arena of its own.
+**/
+typedef struct Arena {
+    ArenaBlock* blocks;         // Block allocations are carved from, followed by the filled ones
+    size_t next_block_size;     // Size of the next block to add
+    size_t allocated;           // Bytes handed out
+    size_t reserved;            // Bytes of blocks obtained from malloc
+} Arena;
+
+/**
+ * arenaInit function sets up an empty arena; the first block is added by the first allocation.
+
+   Parameters:
+   - arena: The Arena to set up.
+**/
+void arenaInit(Arena* arena);
+
+/**
+ * arenaAlloc function returns size bytes of uninitialized memory from the arena, aligned to ARENA_ALIGNMENT,
+ * adding a block if the current one is full. Returns NULL if a block cannot be allocated.
+
+   Parameters:
+   - arena: The Arena to allocate from.
+   - size: The number of bytes to allocate.
+**/
+void* arenaAlloc(Arena* arena, size_t size);
+
+/**
+ * arenaCalloc function is arenaAlloc with the memory cleared to zero.
+
+   Parameters:
+   - arena: The Arena to allocate from.
+   - size: The number of bytes to allocate.
+**/
+void* arenaCalloc(Arena* arena, size_t size);
+
+/**
+ * arenaRelease function frees every block of the arena, invalidating everything allocated from it,
+ * and leaves the arena empty. Blocks mapped from a state image are left to the image. The Arena structure itself
+ * may live in memory allocated from the arena, as it is read before the first block is freed.
+
+   Parameters:
+   - arena: The Arena to release.
+**/
+void arenaRelease(Arena* arena);
+
+#endif // ARENA_H
@@ -0,0 +1,118 @@
+#include <stdio.h>          // For printf
+#include <stdlib.h>         // For dynamic memory allocation
+#include <time.h>           // For clock_gettime
+#include <unistd.h>         // For dup, sysconf
+#include <fcntl.h>          // For open
+#include <sys/resource.h>   // For getrusage
+#include "../page_table.h"
+#include "../tlb.h"
+#include "../replacement.h"
+#include "../slab.h"
+#include "../process_table.h"
+
+// Benchmark of process churn: every round creates a batch of processes of mixed sizes, touches a few pages of each,
+// then destroys them in random order. It reports the time per create_process and destroy_process call and the
+// resident set size after each phase, so page table metadata that is not given back shows up as growing RSS.
+//
+// Build and run from the implementation directory:
+//   gcc -O2 -pthread -o churn_bench benchmarks/churn_bench.c memory_config.c physical_memory.c page_table.c tlb.c
+//       replacement.c event_trace.c slab.c arena.c process_table.c shared_segment.c swap.c && ./churn_bench
+
+#define ROUNDS 40
+#define PROCESSES_PER_ROUND 256
+#define PAGES_TOUCHED 8
+
+// Process sizes are log-uniform between 2^MIN_SIZE_SHIFT and 2^MAX_SIZE_SHIFT bytes, plus a random tail
+#define MIN_SIZE_SHIFT 12
+#define MAX_SIZE_SHIFT 26
+
+// Globals the paging engine expects from main.c
+int page_faults;
+int page_evictions;
+int num_accesses;
+
+static double elapsedSeconds(struct timespec start, struct timespec end) {
+    return (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9;
+}
+
+// Function to read the current resident set size in KB
+static long residentKB(void) {
+    long size = 0, pages = 0;
+    FILE* statm = fopen("/proc/self/statm", "r");
+    if (statm == NULL) return -1;
+    if (fscanf(statm, "%ld %ld", &size, &pages) != 2) pages = -1;
+    fclose(statm);
+    return pages < 0 ? -1 : pages * (sysconf(_SC_PAGESIZE) / 1024);
+}
+
+int main(void) {
+    MemoryConfig config = defaultMemoryConfig();
+    VirtualMemory* vm = initializeVirtualMemory(&config);
+    PhysicalMemory* pm = initializePhysicalMemory(&config);
+    if (!vm || !pm || initializeReplacement("clock", config.num_frames) != 0
+        || initializeTLB(config.tlb_entries, config.tlb_ways, config.tlb_asid_tagged) != 0 || initializeSlabs(pm) != 0) {
+        fprintf(stderr, "Failed to initialize memory structures.\n");
+        return 1;
+    }
+
+    // The engine reports every destroyed process on stdout: keep the CSV on the original stdout and discard the rest
+    FILE* csv = fdopen(dup(STDOUT_FILENO), "w");
+    int devNull = open("/dev/null", O_WRONLY);
+    if (csv == NULL || devNull == -1) return 1;
+    fflush(stdout);
+    dup2(devNull, STDOUT_FILENO);
+
+    fprintf(csv, "round,processes,create_ns_per_op,destroy_ns_per_op,rss_after_create_kb,rss_after_destroy_kb\n");
+    srand(42);
+    int nextPid = 1;
+    int pids[PROCESSES_PER_ROUND];
+    for (int round = 0; round < ROUNDS; round++) {
+        struct timespec start, end;
+
+        // Create the batch, timing create_process alone
+        double createSeconds = 0;
+        for (int i = 0; i < PROCESSES_PER_ROUND; i++) {
+            int shift = MIN_SIZE_SHIFT + rand() % (MAX_SIZE_SHIFT - MIN_SIZE_SHIFT);
+            long long size = (1LL << shift) + rand() % (1 << MIN_SIZE_SHIFT);
+            clock_gettime(CLOCK_MONOTONIC, &start);
+            Process* process = create_process(nextPid, size, vm);
+            clock_gettime(CLOCK_MONOTONIC, &end);
+            createSeconds += elapsedSeconds(start, end);
+            if (process == NULL || registerProcess(process).slot == -1) return 1;
+            pids[i] = nextPid++;
+
+            long long pages = (size + config.page_mask) >> config.page_shift;
+            for (int j = 0; j < PAGES_TOUCHED; j++) {
+                accessMemory(process, rand() % pages, j & 1, pm);
+            }
+        }
+        long rssAfterCreate = residentKB();
+
+        // Destroy the batch in random order, timing destroy_process alone
+        double destroySeconds = 0;
+        for (int remaining = PROCESSES_PER_ROUND; remaining > 0; remaining--) {
+            int index = rand() % remaining;
+            clock_gettime(CLOCK_MONOTONIC, &start);
+            destroy_process(pids[index], vm, pm);
+            clock_gettime(CLOCK_MONOTONIC, &end);
+            destroySeconds += elapsedSeconds(start, end);
+            pids[index] = pids[remaining - 1];
+        }
+        long rssAfterDestroy = residentKB();
+
+        fprintf(csv, "%d,%d,%.0f,%.0f,%ld,%ld\n", round, PROCESSES_PER_ROUND, createSeconds * 1e9 / PROCESSES_PER_ROUND,
+                destroySeconds * 1e9 / PROCESSES_PER_ROUND, rssAfterCreate, rssAfterDestroy);
+    }
+
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    fprintf(csv, "# peak RSS: %ld KB\n", usage.ru_maxrss);
+    fclose(csv);
+
+    freeSlabs();
+    freeTLB();
+    freeReplacement();
+    freeProcessTable();
+    freeMemory(vm, pm);
+    return 0;
+}
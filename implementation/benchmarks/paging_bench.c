@@ -0,0 +1,417 @@
+#include <stdio.h>          // For printf
+#include <stdlib.h>         // For dynamic memory allocation and qsort
+#include <string.h>         // For strcmp
+#include <time.h>           // For clock_gettime
+#include <unistd.h>         // For dup
+#include <fcntl.h>          // For open
+#include "../page_table.h"
+#include "../tlb.h"
+#include "../replacement.h"
+#include "../slab.h"
+#include "../process_table.h"
+#include "../shared_segment.h"
+
+// Benchmark suite of the paging engine's core operations: create_process, allocatePagesToPhysicalMemory,
+// accessMemory, translateVirtualToPhysicalAddress, findFreeFrame and destroy_process, each run at several scales
+// (number of processes, process sizes, how full physical memory is) and, for accesses, under several access patterns.
+// Every call is timed on its own; each case reports ns/op and ops/s over all its calls, and the p50 and p99 latency
+// of a single call. The results are printed as CSV (one row per case), or as JSON with --json, to be diffed across
+// commits. The default memory geometry and the Clock policy are used, as by main.
+//
+// Build and run from the implementation directory:
+//   gcc -O2 -pthread -o paging_bench benchmarks/paging_bench.c memory_config.c physical_memory.c page_table.c tlb.c
+//       replacement.c event_trace.c slab.c arena.c process_table.c shared_segment.c swap.c && ./paging_bench
+//   ./paging_bench --json --quick   # JSON, with a tenth of the accesses per case
+
+// Calls timed per access and translation case, and per findFreeFrame case
+#define ACCESS_OPS 200000
+#define FRAME_OPS 100000
+
+// Creations timed per create_process case, and calls timed at least per allocation and destruction case
+#define CREATE_OPS 1000
+#define MIN_SAMPLES 256
+
+// Pages apart of consecutive accesses of the strided pattern
+#define ACCESS_STRIDE 16
+
+// Globals the paging engine expects from main.c
+int page_faults;
+int page_evictions;
+int num_accesses;
+
+// Define the BenchCase structure, the parameters of a case as reported
+typedef struct BenchCase {
+    const char* operation;
+    int processes;              // Processes the case runs over
+    long long process_size;     // Bytes per process
+    double fullness;            // Physical memory in use before the calls (for accesses: the working set), in percent
+    const char* pattern;        // Access pattern, or order of the calls
+} BenchCase;
+
+static MemoryConfig config;
+static VirtualMemory* vm = NULL;
+static PhysicalMemory* pm = NULL;
+static int nextPid = 1;
+
+// Latency of every call of the current case
+static long long* samples = NULL;
+static long long sampleCount;
+
+static FILE* out;
+static bool json = false;
+static int reported = 0;
+static int opsDivisor = 1;
+
+
+static inline long long nowNs(void) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return now.tv_sec * 1000000000LL + now.tv_nsec;
+}
+
+// xorshift64*, so the access streams do not depend on the C library's rand
+static unsigned long long rngState = 42;
+static unsigned long long nextRandom(void) {
+    rngState ^= rngState >> 12;
+    rngState ^= rngState << 25;
+    rngState ^= rngState >> 27;
+    return rngState * 2685821657736338717ULL;
+}
+
+// Function to set up an empty simulation with the default geometry
+static void setUp(void) {
+    config = defaultMemoryConfig();
+    vm = initializeVirtualMemory(&config);
+    pm = initializePhysicalMemory(&config);
+    if (!vm || !pm || initializeReplacement("clock", config.num_frames) != 0
+        || initializeTLB(config.tlb_entries, config.tlb_ways, config.tlb_asid_tagged) != 0
+        || initializeSlabs(pm) != 0 || initializeSharedSegments(pm) != 0) {
+        fprintf(stderr, "Failed to initialize memory structures.\n");
+        exit(1);
+    }
+    config = vm->config;
+}
+
+// Function to destroy every process and release the simulation
+static void tearDown(void) {
+    int count = countProcesses();
+    int* pids = malloc((count ? count : 1) * sizeof(int));
+    if (pids == NULL) exit(1);
+    Process* process;
+    int n = 0;
+    for (int cursor = 0; (process = nextProcess(&cursor)) != NULL; ) pids[n++] = process->id;
+    for (int i = 0; i < n; i++) destroy_process(pids[i], vm, pm);
+    free(pids);
+
+    freeSharedSegments();
+    freeSlabs();
+    freeTLB();
+    freeReplacement();
+    freeProcessTable();
+    freeMemory(vm, pm);
+    vm = NULL;
+    pm = NULL;
+}
+
+// Function to create and register a process, exiting if it cannot be
+static Process* newProcess(long long size) {
+    Process* process = create_process(nextPid++, size, vm);
+    if (process == NULL || registerProcess(process).slot == -1) {
+        fprintf(stderr, "Failed to create a process of %lld bytes.\n", size);
+        exit(1);
+    }
+    return process;
+}
+
+// Function to fill the whole physical memory with the pages of one process, so further mappings evict
+static void fillPhysicalMemory(void) {
+    allocatePagesToPhysicalMemory(newProcess(config.physical_memory_size), pm);
+}
+
+static int compareSamples(const void* a, const void* b) {
+    long long x = *(const long long*)a, y = *(const long long*)b;
+    return x < y ? -1 : x > y;
+}
+
+// Function to print the results of a case from its samples
+static void report(BenchCase c) {
+    long long total = 0;
+    for (long long i = 0; i < sampleCount; i++) total += samples[i];
+    qsort(samples, sampleCount, sizeof(long long), compareSamples);
+    double nsPerOp = sampleCount ? (double)total / sampleCount : 0;
+    long long p50 = sampleCount ? samples[sampleCount * 50 / 100] : 0;
+    long long p99 = sampleCount ? samples[sampleCount * 99 / 100] : 0;
+
+    if (json) {
+        fprintf(out, "%s\n    {\"operation\": \"%s\", \"processes\": %d, \"process_size\": %lld, \"fullness_pct\": %.1f, "
+                "\"pattern\": \"%s\", \"ops\": %lld, \"ns_per_op\": %.1f, \"ops_per_sec\": %.0f, \"p50_ns\": %lld, "
+                "\"p99_ns\": %lld}", reported ? "," : "", c.operation, c.processes, c.process_size, c.fullness, c.pattern,
+                sampleCount, nsPerOp, nsPerOp > 0 ? 1e9 / nsPerOp : 0, p50, p99);
+    } else {
+        fprintf(out, "%s,%d,%lld,%.1f,%s,%lld,%.1f,%.0f,%lld,%lld\n", c.operation, c.processes, c.process_size, c.fullness,
+                c.pattern, sampleCount, nsPerOp, nsPerOp > 0 ? 1e9 / nsPerOp : 0, p50, p99);
+    }
+    fflush(out);
+    reported++;
+    sampleCount = 0;
+}
+
+// create_process: processes of one size, created one after the other
+static void benchCreate(int processes, long long size) {
+    setUp();
+    for (int i = 0; i < processes; i++) {
+        long long start = nowNs();
+        Process* process = create_process(nextPid++, size, vm);
+        samples[sampleCount++] = nowNs() - start;
+        if (process == NULL || registerProcess(process).slot == -1) exit(1);
+    }
+    tearDown();
+    report((BenchCase){ "create_process", processes, size, 0, "-" });
+}
+
+// Function to get the number of processes of a size that take half of physical memory, at least one
+static int halfMemoryProcesses(long long size) {
+    long long processes = config.physical_memory_size / 2 / size;
+    return processes > 0 ? (int)processes : 1;
+}
+
+// allocatePagesToPhysicalMemory: processes of one size, filling half of physical memory, which is empty or full
+static void benchAllocate(long long size, bool full) {
+    int processes = 0;
+    while (sampleCount < MIN_SAMPLES) {
+        setUp();
+        if (full) fillPhysicalMemory();
+        processes = halfMemoryProcesses(size);
+        for (int i = 0; i < processes; i++) {
+            Process* process = newProcess(size);
+            long long start = nowNs();
+            allocatePagesToPhysicalMemory(process, pm);
+            samples[sampleCount++] = nowNs() - start;
+        }
+        tearDown();
+    }
+    report((BenchCase){ "allocatePagesToPhysicalMemory", processes, size, full ? 100 : 0, "-" });
+}
+
+// destroy_process: fully resident processes of one size, filling half of physical memory, destroyed in random order
+static void benchDestroy(long long size) {
+    int processes = 0;
+    while (sampleCount < MIN_SAMPLES) {
+        setUp();
+        processes = halfMemoryProcesses(size);
+        int* pids = malloc(processes * sizeof(int));
+        if (pids == NULL) exit(1);
+        for (int i = 0; i < processes; i++) {
+            Process* process = newProcess(size);
+            allocatePagesToPhysicalMemory(process, pm);
+            pids[i] = process->id;
+        }
+        for (int remaining = processes; remaining > 0; remaining--) {
+            int index = nextRandom() % remaining;
+            long long start = nowNs();
+            destroy_process(pids[index], vm, pm);
+            samples[sampleCount++] = nowNs() - start;
+            pids[index] = pids[remaining - 1];
+        }
+        free(pids);
+        tearDown();
+    }
+    report((BenchCase){ "destroy_process", processes, size, 50, "random" });
+}
+
+// Function to pick the process and page of access i of a pattern over `processes` processes of `pages` pages each
+static void nextAccess(const char* pattern, long long i, int processes, long long pages, int* process, long long* vpn) {
+    long long total = processes * pages;
+    long long index;
+    if (strcmp(pattern, "sequential") == 0) {
+        index = i % total;
+    } else if (strcmp(pattern, "strided") == 0) {
+        // Every ACCESS_STRIDE-th page, then the pass again one page further on
+        long long k = i % total;
+        long long passes = (total + ACCESS_STRIDE - 1) / ACCESS_STRIDE;
+        index = (k % passes) * ACCESS_STRIDE + k / passes;
+        if (index >= total) index = k;
+    } else if (strcmp(pattern, "hotspot") == 0) {
+        // 90% of the accesses go to 10% of the pages
+        long long hot = total / 10 > 0 ? total / 10 : 1;
+        index = nextRandom() % 10 < 9 ? (long long)(nextRandom() % hot) : (long long)(nextRandom() % total);
+    } else {
+        index = nextRandom() % total;
+    }
+    *process = index / pages;
+    *vpn = index % pages;
+}
+
+// Function to create `processes` processes sharing a working set of workingSet percent of physical memory
+static Process** createWorkingSet(int processes, double workingSet, long long* pages) {
+    long long totalPages = (long long)(config.num_frames * workingSet / 100);
+    *pages = totalPages / processes;
+    Process** set = malloc(processes * sizeof(Process*));
+    if (set == NULL) exit(1);
+    for (int i = 0; i < processes; i++) set[i] = newProcess(*pages << config.page_shift);
+    return set;
+}
+
+// accessMemory: one access in four is a write; the calls are timed after a pass that faults the working set in
+static void benchAccess(int processes, double workingSet, const char* pattern) {
+    setUp();
+    long long pages;
+    Process** set = createWorkingSet(processes, workingSet, &pages);
+    long long ops = ACCESS_OPS / opsDivisor;
+    int process;
+    long long vpn;
+    for (long long i = 0; i < ops; i++) {
+        nextAccess(pattern, i, processes, pages, &process, &vpn);
+        accessMemory(set[process], vpn, (i & 3) == 0, pm);
+    }
+    for (long long i = 0; i < ops; i++) {
+        nextAccess(pattern, i, processes, pages, &process, &vpn);
+        long long start = nowNs();
+        accessMemory(set[process], vpn, (i & 3) == 0, pm);
+        samples[sampleCount++] = nowNs() - start;
+    }
+    free(set);
+    tearDown();
+    report((BenchCase){ "accessMemory", processes, pages << config.page_shift, workingSet, pattern });
+}
+
+// translateVirtualToPhysicalAddress: the addresses are formatted before the calls are timed
+static void benchTranslate(int processes, double workingSet, const char* pattern) {
+    setUp();
+    long long pages;
+    Process** set = createWorkingSet(processes, workingSet, &pages);
+    long long ops = ACCESS_OPS / opsDivisor;
+    char (*addresses)[32] = malloc(ops * sizeof(*addresses));
+    int* pids = malloc(ops * sizeof(int));
+    if (addresses == NULL || pids == NULL) exit(1);
+    for (long long i = 0; i < ops; i++) {
+        int process;
+        long long vpn;
+        nextAccess(pattern, i, processes, pages, &process, &vpn);
+        snprintf(addresses[i], sizeof(addresses[i]), "0vp%llds%lld", vpn, (long long)(nextRandom() % config.page_size));
+        pids[i] = set[process]->id;
+    }
+
+    char physicalAddress[32];
+    for (long long i = 0; i < ops; i++) translateVirtualToPhysicalAddress(pm, addresses[i], pids[i], physicalAddress);
+    for (long long i = 0; i < ops; i++) {
+        long long start = nowNs();
+        translateVirtualToPhysicalAddress(pm, addresses[i], pids[i], physicalAddress);
+        samples[sampleCount++] = nowNs() - start;
+    }
+    free(addresses);
+    free(pids);
+    free(set);
+    tearDown();
+    report((BenchCase){ "translateVirtualToPhysicalAddress", processes, pages << config.page_shift, workingSet, pattern });
+}
+
+// findFreeFrame: with fullness percent of the frames allocated, either the lowest ones ("packed") or frames picked
+// at random ("scattered")
+static void benchFindFreeFrame(double fullness, bool scattered) {
+    setUp();
+    long long allocated = (long long)(config.num_frames * fullness / 100);
+    if (scattered) {
+        // Allocate every frame, then free a random selection of the ones that should be free
+        while (allocateFrameBlock(pm, 0) != -1) continue;
+        int* frames = malloc(config.num_frames * sizeof(int));
+        if (frames == NULL) exit(1);
+        for (int i = 0; i < config.num_frames; i++) frames[i] = i;
+        for (long long i = config.num_frames - 1; i > 0; i--) {
+            long long j = nextRandom() % (i + 1);
+            int swap = frames[i];
+            frames[i] = frames[j];
+            frames[j] = swap;
+        }
+        for (long long i = allocated; i < config.num_frames; i++) freeFrameBlock(pm, frames[i], 0);
+        free(frames);
+    } else {
+        for (long long i = 0; i < allocated; i++) allocateFrameBlock(pm, 0);
+    }
+
+    long long ops = FRAME_OPS / opsDivisor;
+    volatile int sink = 0;
+    for (long long i = 0; i < ops; i++) {
+        long long start = nowNs();
+        sink += findFreeFrame(pm);
+        samples[sampleCount++] = nowNs() - start;
+    }
+    (void)sink;
+    tearDown();
+    report((BenchCase){ "findFreeFrame", 0, 0, fullness, scattered ? "scattered" : "packed" });
+}
+
+// Function to measure the cost of reading the clock, which every sample includes
+static long long clockOverhead(void) {
+    for (int i = 0; i < 1000; i++) {
+        long long start = nowNs();
+        samples[i] = nowNs() - start;
+    }
+    qsort(samples, 1000, sizeof(long long), compareSamples);
+    return samples[500];
+}
+
+int main(int argc, char* argv[]) {
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--json") == 0) {
+            json = true;
+        } else if (strcmp(argv[i], "--quick") == 0) {
+            opsDivisor = 10;
+        } else {
+            printf("Usage: %s [--json] [--quick]\n", argv[0]);
+            return 1;
+        }
+    }
+
+    // The engine reports every destroyed process on stdout: keep the results on the original stdout and discard the rest
+    out = fdopen(dup(STDOUT_FILENO), "w");
+    int devNull = open("/dev/null", O_WRONLY);
+    if (out == NULL || devNull == -1) return 1;
+    fflush(stdout);
+    dup2(devNull, STDOUT_FILENO);
+
+    // The largest case is an access case; a round of allocations or destructions takes at most half the frames' worth
+    samples = malloc((ACCESS_OPS + CREATE_OPS * 10) * sizeof(long long));
+    if (samples == NULL) return 1;
+    long long overhead = clockOverhead();
+    if (json) {
+        fprintf(out, "{\n  \"clock_overhead_ns\": %lld,\n  \"results\": [", overhead);
+    } else {
+        fprintf(out, "# Every sample includes the cost of reading the clock: %lld ns\n", overhead);
+        fprintf(out, "operation,processes,process_size,fullness_pct,pattern,ops,ns_per_op,ops_per_sec,p50_ns,p99_ns\n");
+    }
+
+    benchCreate(CREATE_OPS, 64 * KB);
+    benchCreate(CREATE_OPS, 64 * MB);
+    benchCreate(CREATE_OPS * 10, 64 * KB);
+
+    long long sizes[] = { 64 * KB, 1 * MB, 16 * MB };
+    for (int i = 0; i < 3; i++) benchAllocate(sizes[i], false);
+    for (int i = 0; i < 3; i++) benchAllocate(sizes[i], true);
+
+    const char* patterns[] = { "sequential", "strided", "random", "hotspot" };
+    int processCounts[] = { 1, 64 };
+    double workingSets[] = { 50, 200 };
+    for (int p = 0; p < 2; p++) {
+        for (int w = 0; w < 2; w++) {
+            for (int a = 0; a < 4; a++) benchAccess(processCounts[p], workingSets[w], patterns[a]);
+        }
+    }
+    for (int p = 0; p < 2; p++) {
+        benchTranslate(processCounts[p], 50, "sequential");
+        benchTranslate(processCounts[p], 50, "random");
+    }
+
+    double fullness[] = { 0, 50, 90, 99.9 };
+    for (int f = 0; f < 4; f++) {
+        benchFindFreeFrame(fullness[f], false);
+        benchFindFreeFrame(fullness[f], true);
+    }
+
+    for (int i = 0; i < 3; i++) benchDestroy(sizes[i]);
+
+    if (json) fprintf(out, "\n  ]\n}\n");
+    fclose(out);
+    free(samples);
+    return 0;
+}
@@ -0,0 +1,96 @@
+#include <stdio.h>  // For printf
+#include <stdlib.h> // For dynamic memory allocation
+#include <time.h>   // For clock_gettime
+#include "../page_table.h"
+
+// Benchmark comparing page table walk throughput of the original PageTableEntry layout
+// (page_num, frame_num, is_valid and an int per chunk, 28 bytes) with the packed 8-byte layout.
+// Each walk visits every entry of an address space and sums the frames of present pages,
+// for a 256MB address space and for a 16x larger one that no longer fits in cache.
+//
+// Build and run from the implementation directory:
+//   gcc -O2 -o pte_walk_bench benchmarks/pte_walk_bench.c && ./pte_walk_bench
+
+// The PageTableEntry layout before it was packed
+typedef struct LegacyPageTableEntry {
+    int page_num;
+    int frame_num;
+    bool is_valid;
+    int chunks[DEFAULT_PAGE_SIZE / DEFAULT_CHUNK_SIZE];
+} LegacyPageTableEntry;
+
+// Pages in the smaller address space walked (256MB)
+#define WALK_PAGES (256LL * MB / DEFAULT_PAGE_SIZE)
+
+// Frames the present pages are spread over (the default physical memory)
+#define WALK_FRAMES (DEFAULT_PHYSICAL_MEMORY_SIZE / DEFAULT_PAGE_SIZE)
+
+// Number of entries walked per size, so both sizes take similar time
+#define WALKED_ENTRIES (400LL * WALK_PAGES)
+
+static double elapsedSeconds(struct timespec start, struct timespec end) {
+    return (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9;
+}
+
+// Function to walk both layouts of an address space with `entries` pages and print one CSV row per layout
+static int benchmarkWalk(long long entries) {
+    LegacyPageTableEntry* legacy = malloc(entries * sizeof(LegacyPageTableEntry));
+    PageTableEntry* packed = malloc(entries * sizeof(PageTableEntry));
+    if (!legacy || !packed) return 1;
+
+    // Half of the pages are present, scattered pseudo-randomly
+    srand(42);
+    for (long long i = 0; i < entries; i++) {
+        int present = rand() & 1;
+        legacy[i].page_num = i;
+        legacy[i].frame_num = present ? i % WALK_FRAMES : -1;
+        legacy[i].is_valid = true;
+        for (int j = 0; j < DEFAULT_PAGE_SIZE / DEFAULT_CHUNK_SIZE; j++) legacy[i].chunks[j] = j;
+
+        packed[i] = PTE_EMPTY | PTE_VALID | PTE_PROT_READ | PTE_PROT_WRITE;
+        pteSetChunkMask(&packed[i], 0xF);
+        if (present) pteSetFrame(&packed[i], i % WALK_FRAMES);
+    }
+
+    int rounds = WALKED_ENTRIES / entries;
+    struct timespec start, end;
+    long long legacySum = 0, packedSum = 0;
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (int round = 0; round < rounds; round++) {
+        for (long long i = 0; i < entries; i++) {
+            if (legacy[i].is_valid && legacy[i].frame_num != -1) legacySum += legacy[i].frame_num;
+        }
+        __asm__ volatile("" : : "r"(legacy) : "memory"); // Keep the compiler from folding the rounds together
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    double legacySeconds = elapsedSeconds(start, end);
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (int round = 0; round < rounds; round++) {
+        for (long long i = 0; i < entries; i++) {
+            PageTableEntry pte = packed[i];
+            if ((pte & (PTE_VALID | PTE_PRESENT)) == (PTE_VALID | PTE_PRESENT)) packedSum += pteFrame(pte);
+        }
+        __asm__ volatile("" : : "r"(packed) : "memory");
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    double packedSeconds = elapsedSeconds(start, end);
+
+    double walked = (double)entries * rounds;
+    printf("legacy,%lld,%llu,%llu,%.0f,%.3f\n", entries, (unsigned long long)sizeof(LegacyPageTableEntry),
+           (unsigned long long)(sizeof(LegacyPageTableEntry) * entries), walked / legacySeconds, legacySeconds * 1e9 / walked);
+    printf("packed,%lld,%llu,%llu,%.0f,%.3f\n", entries, (unsigned long long)sizeof(PageTableEntry),
+           (unsigned long long)(sizeof(PageTableEntry) * entries), walked / packedSeconds, packedSeconds * 1e9 / walked);
+
+    free(legacy);
+    free(packed);
+    return legacySum == packedSum ? 0 : 1; // Both walks must agree
+}
+
+int main(void) {
+    printf("layout,entries,entry_bytes,table_bytes,entries_per_sec,ns_per_entry\n");
+    int status = benchmarkWalk(WALK_PAGES);
+    status |= benchmarkWalk(16 * WALK_PAGES);
+    return status;
+}
@@ -0,0 +1,57 @@
+#include <stdio.h>  // For file input and output
+#include <string.h> // For string manipulation
+#include "event_trace.h"
+
+// Decoder for event files written by the event drainer (main --events <file>).
+// Prints one line per event, or with --summary the number of events of each type.
+
+int main(int argc, char* argv[]) {
+    int summary = argc == 3 && strcmp(argv[1], "--summary") == 0;
+    if (argc != 2 && !summary) {
+        printf("Usage: %s [--summary] <event file>\n", argv[0]);
+        return 1;
+    }
+
+    const char* path = argv[argc - 1];
+    FILE* file = fopen(path, "rb");
+    if (file == NULL) {
+        perror(path);
+        return 1;
+    }
+
+    EventFileHeader header;
+    if (fread(&header, sizeof(header), 1, file) != 1 || memcmp(header.magic, EVENT_FILE_MAGIC, sizeof(header.magic)) != 0
+        || header.version != EVENT_FILE_VERSION || header.event_size != sizeof(TraceEvent)) {
+        printf("%s is not a version %d event file.\n", path, EVENT_FILE_VERSION);
+        fclose(file);
+        return 1;
+    }
+
+    long long counts[EVENT_DESTROY + 1] = { 0 };
+    long long total = 0;
+    uint64_t firstTimestamp = 0;
+    TraceEvent events[4096];
+    size_t read;
+    while ((read = fread(events, sizeof(TraceEvent), 4096, file)) > 0) {
+        for (size_t i = 0; i < read; i++) {
+            const TraceEvent* event = &events[i];
+            if (total++ == 0) firstTimestamp = event->timestamp_ns;
+            if (event->type >= EVENT_FAULT && event->type <= EVENT_DESTROY) counts[event->type]++;
+
+            if (!summary) {
+                printf("%12.3f us  thread %-2u %-7s pid %-6d vpn %-8lld frame %d\n",
+                       (event->timestamp_ns - firstTimestamp) / 1000.0, event->thread, eventTypeName(event->type),
+                       event->pid, (long long)event->vpn, event->frame);
+            }
+        }
+    }
+    fclose(file);
+
+    if (summary) {
+        printf("Events: %lld\n", total);
+        for (int type = EVENT_FAULT; type <= EVENT_DESTROY; type++) {
+            printf("%-8s %lld\n", eventTypeName(type), counts[type]);
+        }
+    }
+    return 0;
+}
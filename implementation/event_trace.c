@@ -0,0 +1,175 @@
+#include <stdio.h>      // For file output
+#include <stdlib.h>     // For dynamic memory allocation
+#include <string.h>     // For memcpy
+#include <stdbool.h>    // For bool type
+#include <stdatomic.h>  // For the lock-free ring indices
+#include <pthread.h>    // For the drainer thread
+#include <time.h>       // For clock_gettime and nanosleep
+#include "event_trace.h"
+
+
+#define MAX_EVENT_RINGS 64
+
+// Define the EventRing structure, a single-producer single-consumer ring of events
+typedef struct EventRing {
+    _Atomic uint64_t head;      // Next slot the producer writes, only advanced by the owning thread
+    _Atomic uint64_t tail;      // Next slot the drainer reads, only advanced by the drainer
+    uint16_t index;             // Position in the ring registry
+    TraceEvent events[EVENT_RING_CAPACITY];
+} EventRing;
+
+static EventRing* _Atomic rings[MAX_EVENT_RINGS]; // Registry of every thread's ring
+static _Atomic int ringCount = 0;
+static _Thread_local EventRing* threadRing = NULL;
+
+static atomic_bool recording = false;
+static atomic_bool draining = false;
+static _Atomic long long dropped = 0;
+static FILE* eventFile = NULL;
+static long long eventsWritten = 0;
+static pthread_t drainerThread;
+
+
+// Function to get the calling thread's ring, creating and registering it on first use
+static EventRing* getThreadRing(void) {
+    if (threadRing != NULL) return threadRing;
+
+    int index = atomic_fetch_add(&ringCount, 1);
+    if (index >= MAX_EVENT_RINGS) {
+        atomic_fetch_sub(&ringCount, 1);
+        return NULL;
+    }
+    EventRing* ring = calloc(1, sizeof(EventRing));
+    if (ring == NULL) return NULL;
+    ring->index = index;
+    atomic_store_explicit(&rings[index], ring, memory_order_release);
+    threadRing = ring;
+    return ring;
+}
+
+// Function to record an event in the calling thread's ring
+void recordEvent(EventType type, int pid, long long vpn, int frame) {
+    if (!atomic_load_explicit(&recording, memory_order_relaxed)) return; // No drainer running
+
+    EventRing* ring = getThreadRing();
+    if (ring == NULL) {
+        atomic_fetch_add_explicit(&dropped, 1, memory_order_relaxed);
+        return;
+    }
+
+    uint64_t head = atomic_load_explicit(&ring->head, memory_order_relaxed);
+    uint64_t tail = atomic_load_explicit(&ring->tail, memory_order_acquire);
+    if (head - tail == EVENT_RING_CAPACITY) { // Ring is full: drop rather than stall the hot path
+        atomic_fetch_add_explicit(&dropped, 1, memory_order_relaxed);
+        return;
+    }
+
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+
+    TraceEvent* event = &ring->events[head & (EVENT_RING_CAPACITY - 1)];
+    event->timestamp_ns = (uint64_t)now.tv_sec * 1000000000ULL + now.tv_nsec;
+    event->pid = pid;
+    event->vpn = vpn;
+    event->frame = frame;
+    event->type = type;
+    event->thread = ring->index;
+    event->reserved = 0;
+    atomic_store_explicit(&ring->head, head + 1, memory_order_release); // Publish the event to the drainer
+}
+
+// Function to move every published event out of the rings into the event file
+static long long drainRings(void) {
+    long long drained = 0;
+    int count = atomic_load(&ringCount);
+    for (int i = 0; i < count && i < MAX_EVENT_RINGS; i++) {
+        EventRing* ring = atomic_load_explicit(&rings[i], memory_order_acquire);
+        if (ring == NULL) continue; // Registered but not yet published by its thread
+
+        uint64_t tail = atomic_load_explicit(&ring->tail, memory_order_relaxed);
+        uint64_t head = atomic_load_explicit(&ring->head, memory_order_acquire);
+        while (tail != head) {
+            // Write the contiguous stretch up to the head or the end of the ring
+            uint64_t start = tail & (EVENT_RING_CAPACITY - 1);
+            uint64_t length = head - tail;
+            if (start + length > EVENT_RING_CAPACITY) length = EVENT_RING_CAPACITY - start;
+            fwrite(&ring->events[start], sizeof(TraceEvent), length, eventFile);
+            tail += length;
+            drained += length;
+        }
+        atomic_store_explicit(&ring->tail, tail, memory_order_release); // Hand the slots back to the producer
+    }
+    eventsWritten += drained;
+    return drained;
+}
+
+// Drainer thread: poll the rings until stopped
+static void* drainerMain(void* arg) {
+    (void)arg;
+    struct timespec pause = { 0, 1000000 }; // 1 ms between polls of idle rings
+    while (atomic_load(&draining)) {
+        if (drainRings() == 0) {
+            nanosleep(&pause, NULL);
+        }
+    }
+    return NULL;
+}
+
+// Function to start the drainer thread and enable recording
+int startEventDrainer(const char* path) {
+    if (eventFile != NULL) return -1;
+
+    eventFile = fopen(path, "wb");
+    if (eventFile == NULL) {
+        perror(path);
+        return -1;
+    }
+
+    EventFileHeader header = { .version = EVENT_FILE_VERSION, .event_size = sizeof(TraceEvent) };
+    memcpy(header.magic, EVENT_FILE_MAGIC, sizeof(header.magic));
+    fwrite(&header, sizeof(header), 1, eventFile);
+
+    eventsWritten = 0;
+    atomic_store(&draining, true);
+    if (pthread_create(&drainerThread, NULL, drainerMain, NULL) != 0) {
+        atomic_store(&draining, false);
+        fclose(eventFile);
+        eventFile = NULL;
+        return -1;
+    }
+    atomic_store(&recording, true);
+    return 0;
+}
+
+// Function to stop the drainer thread after draining every remaining event
+long long stopEventDrainer(void) {
+    if (eventFile == NULL) return 0;
+
+    atomic_store(&recording, false);
+    atomic_store(&draining, false);
+    pthread_join(drainerThread, NULL);
+    drainRings(); // Events published after the drainer's last poll
+
+    fclose(eventFile);
+    eventFile = NULL;
+    return eventsWritten;
+}
+
+// Function to get the number of dropped events
+long long droppedEvents(void) {
+    return atomic_load(&dropped);
+}
+
+// Function to get the printable name of an event type
+const char* eventTypeName(int type) {
+    switch (type) {
+        case EVENT_FAULT:   return "fault";
+        case EVENT_HIT:     return "hit";
+        case EVENT_MAP:     return "map";
+        case EVENT_UNMAP:   return "unmap";
+        case EVENT_EVICT:   return "evict";
+        case EVENT_CREATE:  return "create";
+        case EVENT_DESTROY: return "destroy";
+        default:            return "unknown";
+    }
+}
@@ -0,0 +1,99 @@
+#include <stdint.h> // For fixed-width event fields
+
+#ifndef EVENT_TRACE_H
+#define EVENT_TRACE_H
+
+// Event levels: an event is compiled in only if its level is at most EVENT_LOG_LEVEL
+#define EVENT_LEVEL_NONE 0      // No events
+#define EVENT_LEVEL_LIFECYCLE 1 // Process creation and destruction
+#define EVENT_LEVEL_PAGING 2    // Page faults, mappings, unmappings and evictions
+#define EVENT_LEVEL_ACCESS 3    // Every successful memory access
+
+// Build with e.g. -DEVENT_LOG_LEVEL=0 to compile every event out of the hot paths
+#ifndef EVENT_LOG_LEVEL
+#define EVENT_LOG_LEVEL EVENT_LEVEL_PAGING
+#endif
+
+typedef enum EventType {
+    EVENT_FAULT = 1,    // Page fault on (pid, vpn); frame is the frame it was resolved to, -1 if none
+    EVENT_HIT,          // Access to (pid, vpn) served by frame
+    EVENT_MAP,          // (pid, vpn) mapped to frame
+    EVENT_UNMAP,        // (pid, vpn) unmapped from frame
+    EVENT_EVICT,        // (pid, vpn) evicted from frame by the replacement policy
+    EVENT_CREATE,       // Process pid created; vpn holds the number of pages
+    EVENT_DESTROY,      // Process pid destroyed
+} EventType;
+
+// Define the TraceEvent structure, the fixed-size binary record written for every event
+typedef struct TraceEvent {
+    uint64_t timestamp_ns;  // CLOCK_MONOTONIC time of the event
+    int64_t vpn;            // Per-process virtual page number, -1 if not applicable
+    int32_t pid;            // Process the event belongs to
+    int32_t frame;          // Frame number, -1 if not applicable
+    uint16_t type;          // EventType
+    uint16_t thread;        // Index of the ring buffer (thread) that recorded the event
+    uint32_t reserved;
+} TraceEvent;
+
+// Event files are an EventFileHeader followed by TraceEvents
+#define EVENT_FILE_MAGIC "PGEV"
+#define EVENT_FILE_VERSION 2
+
+typedef struct EventFileHeader {
+    char magic[4];          // EVENT_FILE_MAGIC
+    uint32_t version;       // EVENT_FILE_VERSION
+    uint32_t event_size;    // sizeof(TraceEvent)
+    uint32_t reserved;
+} EventFileHeader;
+
+// Number of events each thread's ring buffer holds (a power of two)
+#define EVENT_RING_CAPACITY 65536
+
+// Records an event if its level is compiled in; the level test folds away at compile time
+#define TRACE_EVENT(level, type, pid, vpn, frame) \
+    do { if ((level) <= EVENT_LOG_LEVEL) recordEvent((type), (pid), (vpn), (frame)); } while (0)
+
+/**
+ * recordEvent function appends an event to the calling thread's ring buffer. Each thread gets its own
+ * single-producer ring on its first event, so recording never takes a lock. Events are ignored while no drainer
+ * is running, and dropped (and counted) when the drainer falls a full ring behind. Use TRACE_EVENT instead of
+ * calling this directly, so disabled levels cost nothing.
+
+   Parameters:
+   - type: The EventType.
+   - pid: The process the event belongs to.
+   - vpn: The per-process virtual page number, -1 if not applicable.
+   - frame: The frame number, -1 if not applicable.
+**/
+void recordEvent(EventType type, int pid, long long vpn, int frame);
+
+/**
+ * startEventDrainer function starts a background thread that moves events out of every ring buffer into
+ * the file at path, and enables recording. Returns 0 on success, -1 if the file cannot be created or a
+ * drainer is already running.
+
+   Parameters:
+   - path: The path of the event file to write.
+**/
+int startEventDrainer(const char* path);
+
+/**
+ * stopEventDrainer function disables recording, drains the remaining events, stops the drainer thread
+ * and closes the event file. Returns the number of events written.
+**/
+long long stopEventDrainer(void);
+
+/**
+ * droppedEvents function returns the number of events dropped because their ring buffer was full.
+**/
+long long droppedEvents(void);
+
+/**
+ * eventTypeName function returns the printable name of an EventType.
+
+   Parameters:
+   - type: The EventType.
+**/
+const char* eventTypeName(int type);
+
+#endif // EVENT_TRACE_H
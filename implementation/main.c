@@ -1,10 +1,19 @@
 #include <stdio.h>
 #include <stdlib.h> // For dynamic memory allocation and system commands
+#include <string.h> // For strcmp
 #include "page_table.h"
+#include "tlb.h"
+#include "replacement.h"
+#include "trace_replay.h"
+#include "event_trace.h"
+#include "slab.h"
+#include "process_table.h"
+#include "shared_segment.h"
+#include "swap.h"
+#include "snapshot.h"
 
-Process* processes[MAX_PROCESSES]; // Array to store processes
-int processCount = 0; // Keep track of the number of processes
 int page_faults;
+int page_evictions;
 int num_accesses;
 
 void menu() {
@@ -23,19 +32,140 @@ void menu() {
     printf("12. Print Allocated Physical Memory\n");
     printf("13. Print Virtual Memory\n");
     printf("14. Print Physical Memory\n");
+    printf("15. Release Memory\n");
+    printf("16. Fork Process\n");
+    printf("17. Attach Shared Segment\n");
+    printf("18. Detach Shared Segment\n");
+    printf("19. Print Shared Segments\n");
+    printf("20. Save State\n");
     printf("-1. Exit\n");
     printf("Enter your choice: ");
 }
 
-int main() {
-    VirtualMemory* vm = initializeVirtualMemory();
-    PhysicalMemory* pm = initializePhysicalMemory();
+void usage(const char* program) {
+    printf("Usage: %s [--policy fifo|lru|clock] [--trace <file>] [--events <file>]\n", program);
+    printf("       %*s [--page-size <bytes>] [--chunk-size <bytes>] [--physical-memory <bytes>]\n", (int)strlen(program), "");
+    printf("       %*s [--virtual-memory <bytes>] [--huge-pages] [--no-readahead]\n", (int)strlen(program), "");
+    printf("       %*s [--swap <file>] [--swap-size <bytes>] [--load-state <file>] [--save-state <file>]\n", (int)strlen(program), "");
+    printf("       %s --convert-trace <text trace> <binary trace>\n", program);
+}
+
+// Function to replay a trace non-interactively and print the statistics summary
+int runTrace(const char* tracePath, VirtualMemory* vm, PhysicalMemory* pm) {
+    ReplayStats stats;
+    if (replayTrace(tracePath, vm, pm, &stats) != 0) {
+        return 1;
+    }
+
+    printf("\nTrace Replay Summary:\n");
+    printf("Trace: %s\n", tracePath);
+    printf("Accesses replayed: %lld (reads: %lld, writes: %lld)\n", stats.accesses, stats.reads, stats.writes);
+    printf("Invalid records: %lld\n", stats.invalid);
+    printf("Denied by page protection: %lld, unresolved page faults: %lld\n", stats.denied, stats.unresolved);
+    printf("Elapsed time: %.6f s\n", stats.elapsed_seconds);
+    printf("Throughput: %.0f accesses/s\n", stats.elapsed_seconds > 0 ? stats.accesses / stats.elapsed_seconds : 0);
+    displayStatistics(vm, pm);
+    return 0;
+}
+
+int main(int argc, char* argv[]) {
+    // Parse command-line options
+    const char* policyName = "clock";
+    const char* tracePath = NULL;
+    const char* eventsPath = NULL;
+    const char* swapPath = NULL;
+    const char* loadPath = NULL;
+    const char* savePath = NULL;
+    long long swapSize = DEFAULT_SWAP_SIZE;
+    MemoryConfig config = defaultMemoryConfig();
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--policy") == 0 && i + 1 < argc) {
+            policyName = argv[++i];
+        } else if (strcmp(argv[i], "--trace") == 0 && i + 1 < argc) {
+            tracePath = argv[++i];
+        } else if (strcmp(argv[i], "--events") == 0 && i + 1 < argc) {
+            eventsPath = argv[++i];
+        } else if (strcmp(argv[i], "--page-size") == 0 && i + 1 < argc) {
+            config.page_size = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--chunk-size") == 0 && i + 1 < argc) {
+            config.chunk_size = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--physical-memory") == 0 && i + 1 < argc) {
+            config.physical_memory_size = atoll(argv[++i]);
+        } else if (strcmp(argv[i], "--virtual-memory") == 0 && i + 1 < argc) {
+            config.virtual_memory_size = atoll(argv[++i]);
+        } else if (strcmp(argv[i], "--huge-pages") == 0) {
+            config.huge_pages = true;
+        } else if (strcmp(argv[i], "--no-readahead") == 0) {
+            config.readahead = false;
+        } else if (strcmp(argv[i], "--swap") == 0 && i + 1 < argc) {
+            swapPath = argv[++i];
+        } else if (strcmp(argv[i], "--swap-size") == 0 && i + 1 < argc) {
+            swapSize = atoll(argv[++i]);
+        } else if (strcmp(argv[i], "--load-state") == 0 && i + 1 < argc) {
+            loadPath = argv[++i];
+        } else if (strcmp(argv[i], "--save-state") == 0 && i + 1 < argc) {
+            savePath = argv[++i];
+        } else if (strcmp(argv[i], "--convert-trace") == 0 && i + 2 < argc) {
+            return convertTextTrace(argv[i + 1], argv[i + 2]) == 0 ? 0 : 1;
+        } else {
+            usage(argv[0]);
+            return 1;
+        }
+    }
+    if (initializeMemoryConfig(&config) != 0) {
+        usage(argv[0]);
+        return 1;
+    }
+    if (initializeReplacement(policyName, config.num_frames) != 0) {
+        printf("Unknown page replacement policy '%s'.\n", policyName);
+        usage(argv[0]);
+        return 1;
+    }
+
+    // Resume a saved simulation, whose geometry and replacement policy replace the ones given, or start an empty one
+    VirtualMemory* vm = NULL;
+    PhysicalMemory* pm = NULL;
+    if (loadPath != NULL) {
+        if (load_state(loadPath, &vm, &pm) != 0) return 1;
+        config = vm->config;
+    } else {
+        vm = initializeVirtualMemory(&config);
+        pm = initializePhysicalMemory(&config);
+    }
 
-    if (!vm || !pm) {
+    if (!vm || !pm || initializeTLB(config.tlb_entries, config.tlb_ways, config.tlb_asid_tagged) != 0
+        || (loadPath == NULL && initializeSlabs(pm) != 0) || initializeSharedSegments(pm) != 0) { // A loaded state has its slabs
         printf("Failed to initialize memory structures.\n");
         return 1; // Exit with error
     }
 
+    // Write evicted dirty pages to a swap file instead of dropping them
+    if (swapPath != NULL && initializeSwap(swapPath, swapSize, &config) != 0) {
+        printf("Failed to set up the swap device %s.\n", swapPath);
+        return 1;
+    }
+
+    // Record paging events into a file in the background
+    if (eventsPath != NULL && startEventDrainer(eventsPath) != 0) {
+        printf("Failed to start recording events to %s.\n", eventsPath);
+        return 1;
+    }
+
+    // Batch mode: replay the trace instead of showing the menu
+    if (tracePath != NULL) {
+        int status = runTrace(tracePath, vm, pm);
+        if (status == 0 && savePath != NULL && save_state(savePath, vm, pm) != 0) status = 1;
+        stopEventDrainer();
+        freeSwap();
+        freeTLB();
+        freeSlabs();
+        freeSharedSegments();
+        freeReplacement();
+        freeProcessTable();
+        freeMemory(vm, pm);
+        return status;
+    }
+
     while (1) {
         menu();
         int choice;
@@ -44,7 +174,8 @@ int main() {
 
         switch(choice) {
             case 1:     // Create Process
-                int id, memorySize;
+                int id;
+                long long memorySize;
                 printf("Enter process ID: ");
                 scanf("%d", &id);
 
@@ -55,21 +186,25 @@ int main() {
                 }
 
                 printf("Enter memory size (in bytes): ");
-                scanf("%d", &memorySize);
+                scanf("%lld", &memorySize);
 
                 Process* newProcess = create_process(id, memorySize, vm);
-                if (newProcess != NULL) {
-                    processes[processCount++] = newProcess;
+                if (newProcess != NULL && registerProcess(newProcess).slot == -1) {
+                    printf("\nFailed to register process %d.\n", id);
+                    discard_process(newProcess, vm, pm);
+                } else if (newProcess != NULL) {
+                    printf("\nProcess %d created successfully with %lld bytes of memory.\n", id, memorySize);
                 }
                 break;
 
             case 2:     // List Processes
-                if (processCount == 0) {
+                if (countProcesses() == 0) {
                     printf("\nNo processes created yet.\n");
                 } else {
                     printf("\nList of processes:\n");
-                    for (int i = 0; i < processCount; i++) {
-                        printf("Process ID: %d, Memory Size: %d\n", processes[i]->id, processes[i]->memory_size);
+                    Process* listed;
+                    for (int cursor = 0; (listed = nextProcess(&cursor)) != NULL; ) {
+                        printf("Process ID: %d, Memory Size: %lld, Resident: %lld bytes\n", listed->id, listed->memory_size, listed->resident_pages << config.page_shift);
                     }
                 }
                 break;
@@ -100,6 +235,7 @@ int main() {
                 }
 
                 allocatePagesToPhysicalMemory(selectedProcess1, pm);
+                printf("\nPages allocated to physical memory for process %d.\n", pid1);
                 break;
 
             case 5:     // Deallocate Pages from Physical Memory
@@ -114,6 +250,7 @@ int main() {
                 }
 
                 deallocatePagesFromPhysicalMemory(selectedProcess2, pm);
+                printf("\nPages deallocated from physical memory for process %d.\n", pid2);
                 break;            
 
             case 6:
@@ -125,37 +262,40 @@ int main() {
                 if (process != NULL) {
                     // List all pages for the selected process
                     printf("\nListing all pages for Process ID %d:\n", pid3);
-                    for (int i = 0; i < process->mpt->count; i++) {
-                        for (int j = 0; j < (process->mpt->tables[i]->size + PAGE_SIZE - 1) / PAGE_SIZE; j++) {
-                            printf("Page ID: %d\n", process->mpt->tables[i]->entries[j].page_num);
+                    printf("Pages 0-%lld belong to the process; pages of regions not touched yet get a virtual page on first access.\n",
+                           ((process->memory_size + config.page_mask) >> config.page_shift) - 1);
+                    long long base = 0;
+                    SecondaryPageTable* spt;
+                    while ((spt = nextPageTable(process->mpt, &base)) != NULL) {
+                        for (int j = 0; j < ENTRIES_PER_TABLE; j++) {
+                            if (spt->entries[j] & PTE_VALID) {
+                                printf("Page %lld (virtual page ID: %lld)\n", base + j, spt->page_nums[j]);
+                            }
                         }
+                        base += ENTRIES_PER_TABLE;
                     }
                     
-                    printf("\nEnter the Page ID you wish to access: ");
-                    int pageId;
-                    scanf("%d", &pageId);
-                    int accessResult = accessMemory(process, pageId); // This function internally increments num_accesses
-
-                    // result of access is -1 if page fault occurs, 
-                    // handle it by asking the user if they want to allocate the page to physical memory
-                    // if yes, call allocatePagesToPhysicalMemory function
-
-                    if (accessResult == -1) {
-                        printf("Do you want to allocate the page to physical memory? (y/n): ");
-                        char choice;
-                        scanf(" %c", &choice);
-                        if (choice == 'y' || choice == 'Y') {
-                            allocatePagesToPhysicalMemory(process, pm);
-                        } else {
-                            break;
-                        }
+                    printf("\nEnter the page you wish to access: ");
+                    long long pageId;
+                    scanf("%lld", &pageId);
+                    printf("Read or write the page? (r/w): ");
+                    char operation;
+                    scanf(" %c", &operation);
+                    int faultsBefore = page_faults;
+                    int frameNum = accessMemory(process, pageId, operation == 'w' || operation == 'W', pm); // Increments num_accesses and faults the page in if needed
+
+                    if (frameNum == ACCESS_INVALID_PAGE) {
+                        printf("Invalid page %lld access attempt in process ID %d.\n", pageId, pid3);
+                    } else if (frameNum == ACCESS_PROTECTION) {
+                        printf("Access to page %lld in process ID %d not permitted.\n", pageId, pid3);
+                    } else if (frameNum == ACCESS_NO_FRAME) {
+                        printf("Page fault for page %lld in process ID %d could not be resolved: no frame available.\n", pageId, pid3);
                     } else {
-                        break;
+                        if (page_faults != faultsBefore) {
+                            printf("Page fault occurred for page %lld in process ID %d; page loaded into frame %d.\n", pageId, pid3, frameNum);
+                        }
+                        printf("Successfully accessed frame %d for page %lld in process ID %d.\n", frameNum, pageId, pid3);
                     }
-                    
-                    // print the physical memory allocation after the handling of page fault
-                    printf("\nPhysical Memory after handling page fault:\n---------------------------");
-                    printAllocatedFrameMemory(pm);
 
                 } else {
                     printf("\nProcess ID %d not found.\n", pid3);
@@ -168,13 +308,29 @@ int main() {
                 int pid4;
                 scanf("%d", &pid4);
 
-                // enter the virtual address in the form 0vp<page_id>s<offset> e.g. 0vp01s0 for page 1 and offset 0
-                printf("Enter the virtual address in the form 0vp<page_id>s<offset> e.g. 0vp01s0 for page 1 and offset 0: ");
+                // enter the virtual address in the form 0vp<page>s<offset>, where page is the process's own page number e.g. 0vp01s0 for page 1 and offset 0
+                printf("Enter the virtual address in the form 0vp<page>s<offset> e.g. 0vp01s0 for page 1 and offset 0: ");
                 char virtualAddress[20];
                 scanf("%s", virtualAddress);
 
                 // call the function to translate the virtual address to physical address
-                translateVirtualToPhysicalAddress(pm, virtualAddress, pid4);
+                char physicalAddress[32];
+                int faultsBeforeTranslation = page_faults;
+                int translation = translateVirtualToPhysicalAddress(pm, virtualAddress, pid4, physicalAddress);
+                if (translation == ACCESS_INVALID_ADDRESS) {
+                    printf("Invalid virtual address '%s': malformed, or the offset is past the end of the page.\n", virtualAddress);
+                } else if (translation == ACCESS_NO_PROCESS) {
+                    printf("Process with ID %d not found.\n", pid4);
+                } else if (translation == ACCESS_INVALID_PAGE) {
+                    printf("Virtual address '%s' is not part of process ID %d.\n", virtualAddress, pid4);
+                } else if (translation == ACCESS_NO_FRAME) {
+                    printf("No frame available to load virtual address '%s'.\n", virtualAddress);
+                } else {
+                    if (page_faults != faultsBeforeTranslation) {
+                        printf("Page fault: page loaded into frame %d.\n", translation);
+                    }
+                    printf("Physical address for virtual address '%s' of process ID %d: %s\n", virtualAddress, pid4, physicalAddress);
+                }
                 num_accesses++; // increment the number of accesses
                 break;
 
@@ -189,8 +345,8 @@ int main() {
 
                 // request additional memory for the process
                 printf("Enter the additional memory size (in bytes): ");
-                unsigned int additionalMemorySize;
-                scanf("%u", &additionalMemorySize);
+                long long additionalMemorySize;
+                scanf("%lld", &additionalMemorySize);
 
                 requestAdditionalMemory(pid5, additionalMemorySize, vm, pm);
                 break;
@@ -199,19 +355,7 @@ int main() {
                 printf("Enter process ID: ");
                 int pid6;
                 scanf("%d", &pid6);
-                // get the index of the process in the processes array
-                int index;
-                for (index = 0; index < processCount; index++) {
-                    if (processes[index]->id == pid6) {
-                        break;
-                    }
-                }
-                destroy_process(pid6, vm, pm);
-                // remove the process from the processes array
-                for (int i = 0; i < processCount - 1; i++) {
-                    processes[i] = processes[i + 1];
-                }
-                processCount--;
+                destroy_process(pid6, vm, pm); // also removes the process from the process table
                 break;
 
             case 11:     // Print Allocated Virtual Memory
@@ -230,8 +374,91 @@ int main() {
                 printPhysicalMemory(pm);
                 break;
 
+            case 15:    // Release memory
+                printf("Enter process ID: ");
+                int pid7;
+                scanf("%d", &pid7);
+
+                // release memory from the end of the process
+                printf("Enter the memory size to release (in bytes): ");
+                long long releaseSize;
+                scanf("%lld", &releaseSize);
+
+                releaseMemory(pid7, releaseSize, vm, pm);
+                break;
+
+            case 16:    // Fork process
+                printf("Enter parent process ID: ");
+                int parentId;
+                scanf("%d", &parentId);
+                printf("Enter child process ID: ");
+                int childId;
+                scanf("%d", &childId);
+
+                Process* child = fork_process(parentId, childId, vm, pm);
+                if (child != NULL) {
+                    printf("\nProcess %d forked from process %d, sharing %lld resident pages copy-on-write.\n",
+                           childId, parentId, child->resident_pages);
+                }
+                break;
+
+            case 17:    // Attach shared segment
+                printf("Enter process ID: ");
+                int pid8;
+                scanf("%d", &pid8);
+                printf("Enter the segment name: ");
+                char segmentName[SEGMENT_NAME_LENGTH];
+                scanf("%31s", segmentName);
+                printf("Enter the segment size (in bytes, 0 to attach an existing segment): ");
+                long long segmentSize;
+                scanf("%lld", &segmentSize);
+                printf("Enter the page number to attach it at: ");
+                long long segmentPage;
+                scanf("%lld", &segmentPage);
+
+                if (attachSegment(pid8, segmentName, segmentSize, segmentPage, vm) == 0) {
+                    printf("\nSegment %s attached to process %d at page %lld.\n", segmentName, pid8, segmentPage);
+                }
+                break;
+
+            case 18:    // Detach shared segment
+                printf("Enter process ID: ");
+                int pid9;
+                scanf("%d", &pid9);
+                printf("Enter the segment name: ");
+                char detachName[SEGMENT_NAME_LENGTH];
+                scanf("%31s", detachName);
+
+                if (detachSegment(pid9, detachName, vm, pm) == 0) {
+                    printf("\nSegment %s detached from process %d.\n", detachName, pid9);
+                }
+                break;
+
+            case 19:    // Print shared segments
+                printSharedSegments();
+                break;
+
+            case 20:    // Save state
+                printf("Enter the path of the state image: ");
+                char statePath[256];
+                scanf("%255s", statePath);
+
+                if (save_state(statePath, vm, pm) == 0) {
+                    printf("\nState saved to %s.\n", statePath);
+                }
+                break;
+
             case -1:
                 printf("Exiting program.\n");
+                if (savePath != NULL) save_state(savePath, vm, pm);
+                stopEventDrainer();
+                freeSwap();
+                freeTLB();
+                freeSlabs();
+                freeSharedSegments();
+                freeReplacement();
+                freeProcessTable();
+                freeMemory(vm, pm);
                 return 0; // Exit the program
 
             default:
@@ -240,6 +467,13 @@ int main() {
     }
 
     // Once done, free the allocated memory
+    stopEventDrainer();
+    freeSwap();
+    freeTLB();
+    freeSlabs();
+    freeSharedSegments();
+    freeReplacement();
+    freeProcessTable();
     freeMemory(vm, pm);
 
     return 0;
@@ -0,0 +1,59 @@
+#include <stdio.h>  // For printf
+#include "memory_config.h"
+
+
+// Function to return log2 of a power of two, or -1 if value is not a power of two
+static int log2OfPowerOfTwo(long long value) {
+    if (value <= 0 || (value & (value - 1)) != 0) return -1;
+    return __builtin_ctzll(value);
+}
+
+// Function to return the default memory configuration
+MemoryConfig defaultMemoryConfig(void) {
+    MemoryConfig config = {
+        .virtual_memory_size = DEFAULT_VIRTUAL_MEMORY_SIZE,
+        .physical_memory_size = DEFAULT_PHYSICAL_MEMORY_SIZE,
+        .page_size = DEFAULT_PAGE_SIZE,
+        .chunk_size = DEFAULT_CHUNK_SIZE,
+        .tlb_entries = DEFAULT_TLB_ENTRIES,
+        .tlb_ways = DEFAULT_TLB_WAYS,
+        .tlb_asid_tagged = DEFAULT_TLB_ASID_TAGGED,
+        .huge_pages = DEFAULT_HUGE_PAGES,
+        .readahead = DEFAULT_READAHEAD,
+    };
+    initializeMemoryConfig(&config);
+    return config;
+}
+
+// Function to validate a memory configuration and precompute its derived fields
+int initializeMemoryConfig(MemoryConfig* config) {
+    int pageShift = log2OfPowerOfTwo(config->page_size);
+    int chunkShift = log2OfPowerOfTwo(config->chunk_size);
+    if (pageShift == -1 || chunkShift == -1) {
+        printf("Page size and chunk size must be powers of two.\n");
+        return -1;
+    }
+    if (chunkShift > pageShift || pageShift - chunkShift > __builtin_ctz(MAX_CHUNKS_PER_PAGE)) {
+        printf("A page must hold between 1 and %d chunks.\n", MAX_CHUNKS_PER_PAGE);
+        return -1;
+    }
+    if (config->virtual_memory_size <= 0 || config->physical_memory_size <= 0
+        || (config->virtual_memory_size & (config->page_size - 1)) != 0
+        || (config->physical_memory_size & (config->page_size - 1)) != 0) {
+        printf("Virtual and physical memory sizes must be positive multiples of the page size.\n");
+        return -1;
+    }
+    if ((config->virtual_memory_size >> pageShift) > (1LL << VPN_BITS)
+        || (config->physical_memory_size >> pageShift) > 0x7FFFFFFFLL) {
+        printf("Virtual or physical memory has more pages than the page tables can address.\n");
+        return -1;
+    }
+
+    config->page_shift = pageShift;
+    config->page_mask = config->page_size - 1;
+    config->chunk_shift = chunkShift;
+    config->chunks_per_page = 1 << (pageShift - chunkShift);
+    config->num_pages = config->virtual_memory_size >> pageShift;
+    config->num_frames = config->physical_memory_size >> pageShift;
+    return 0;
+}
@@ -4,37 +4,94 @@
 // This file contains the configuration for the memory system
 // It defines the virtual memory space size, physical memory space size, 
 // page size, number of pages and number of frames.
+// The sizes below are the defaults; the geometry actually used is a MemoryConfig chosen at runtime.
 
 
 #ifndef MEMORY_CONFIG_H
 #define MEMORY_CONFIG_H
 
+#include <stdbool.h> // For bool type
+
 #define KB (1024)
 #define MB (1024 * KB)
 #define GB (1024 * MB)
+#define TB (1024ULL * GB)
+
+// default virtual memory space size: 256TB, a 48-bit address space
+// (virtual memory metadata grows with the pages actually handed out, not with this size)
+#define DEFAULT_VIRTUAL_MEMORY_SIZE (1LL << 48)
+
+// default physical memory space size: 128MB
+#define DEFAULT_PHYSICAL_MEMORY_SIZE (128LL * MB)
+
+// default page (and frame) size: 4KB
+#define DEFAULT_PAGE_SIZE (4 * KB)
+
+// default chunk size: 1KB
+#define DEFAULT_CHUNK_SIZE (KB)
+
+// processes map whole huge pages (see HUGE_PAGE_ORDER) only when asked to
+#define DEFAULT_HUGE_PAGES 0
+
+// page faults prefetch the pages that follow a sequential or strided fault stream (see Readahead in page_table.h)
+#define DEFAULT_READAHEAD 1
+
+// TLB: 64 entries, 4-way set associative, tagged with the process ID
+#define DEFAULT_TLB_ENTRIES 64
+#define DEFAULT_TLB_WAYS 4
+#define DEFAULT_TLB_ASID_TAGGED 1
+
+// access times used to estimate the effective memory access time
+#define TLB_LOOKUP_TIME_NS 1
+#define MEMORY_ACCESS_TIME_NS 100
 
-// virtual memory space size: 256MB
-#define VIRTUAL_MEMORY_SIZE (256ULL * MB)
+// a page holds at most this many chunks, so its chunk mask fits in a byte
+#define MAX_CHUNKS_PER_PAGE 8
 
-// physical memory space size: 128MB
-#define PHYSICAL_MEMORY_SIZE (128ULL * MB)
+// bits of a per-process virtual page number: 4 page table levels of 9 bits each (see page_table.h)
+#define VPN_BITS 36
 
-// page size: 4KB
-#define PAGE_SIZE (4 * KB)
+// a huge page maps 2^HUGE_PAGE_ORDER contiguous pages (2MB of 4KB pages), the span of one SecondaryPageTable
+#define HUGE_PAGE_ORDER 9
 
-// frame size: 4KB
-#define FRAME_SIZE PAGE_SIZE
+/**
+ * Define the MemoryConfig structure, the geometry of the simulated memory system.
+ * Fill in the sizes (or start from defaultMemoryConfig) and call initializeMemoryConfig, which checks them and
+ * precomputes the derived fields, so hot paths use shifts and masks instead of dividing by the page size.
+**/
+typedef struct MemoryConfig {
+    long long virtual_memory_size;  // Bytes of virtual memory, a multiple of page_size
+    long long physical_memory_size; // Bytes of physical memory, a multiple of page_size
+    int page_size;                  // Bytes per page and per frame, a power of two
+    int chunk_size;                 // Bytes per chunk, a power of two dividing page_size into at most MAX_CHUNKS_PER_PAGE chunks
+    int tlb_entries;                // Total TLB entries
+    int tlb_ways;                   // TLB associativity
+    bool tlb_asid_tagged;           // TLB entries are tagged with the process ID
+    bool huge_pages;                // New processes map the regions they fully own with huge pages where possible
+    bool readahead;                 // Page faults prefetch the pages a fault stream is about to touch
 
-// number of pages
-#define NUM_PAGES (VIRTUAL_MEMORY_SIZE / PAGE_SIZE)
+    // Derived by initializeMemoryConfig
+    int page_shift;                 // log2(page_size)
+    long long page_mask;            // page_size - 1, the offset bits of an address
+    int chunk_shift;                // log2(chunk_size)
+    int chunks_per_page;            // page_size / chunk_size
+    long long num_pages;            // virtual_memory_size / page_size
+    long long num_frames;           // physical_memory_size / page_size
+} MemoryConfig;
 
-// number of frames
-#define NUM_FRAMES (PHYSICAL_MEMORY_SIZE / PAGE_SIZE)
+/**
+ * defaultMemoryConfig function returns the default geometry (the DEFAULT_* sizes above), already initialized.
+**/
+MemoryConfig defaultMemoryConfig(void);
 
-// chunk size: 1KB
-#define CHUNK_SIZE (KB)
+/**
+ * initializeMemoryConfig function validates the sizes of a MemoryConfig and fills in its derived fields.
+ * It returns 0 on success, or -1 (printing the reason) if a size is not a power of two, does not divide evenly,
+ * or exceeds what the page tables (VPN_BITS bits of page number) and frame numbers (31 bits) can address.
 
-// maximum number of processes
-#define MAX_PROCESSES 100
+   Parameters:
+   - config: The MemoryConfig to validate and complete.
+**/
+int initializeMemoryConfig(MemoryConfig* config);
 
-#endif // MEMORY_CONFIG_H
\ No newline at end of file
+#endif // MEMORY_CONFIG_H
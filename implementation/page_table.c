@@ -3,148 +3,248 @@
 #include <string.h>             // For string manipulation
 #include "page_table.h"     
 #include "virtual_memory.h"
+#include "tlb.h"
+#include "replacement.h"
+#include "event_trace.h"
+#include "slab.h"
+#include "process_table.h"
+#include "shared_segment.h"
+#include "swap.h"
 
 
 // Global variables defined in main.c
 extern int page_faults;
+extern int page_evictions;
 extern int num_accesses;
-extern Process* processes[MAX_PROCESSES];
-extern int processCount;
 
+static HugePageStats hugePageStats;
+static ForkStats forkStats;
+static ReadaheadStats readaheadStats;
+
+
+// Function to get the TLB_PROT_* bits of an entry's protection, cached with its translation
+static inline int pteTlbProt(PageTableEntry entry) {
+    return ((entry & PTE_PROT_READ) ? TLB_PROT_READ : 0) | ((entry & PTE_PROT_WRITE) ? TLB_PROT_WRITE : 0)
+        | ((entry & PTE_PROT_EXEC) ? TLB_PROT_EXEC : 0);
+}
 
 // SecondaryPageTable allocation function
-SecondaryPageTable* allocateSecondaryPageTable(int memorySize) {
-    int numEntries = (memorySize + PAGE_SIZE - 1) / PAGE_SIZE; // Number of pages needed
-    SecondaryPageTable* spt = (SecondaryPageTable*)malloc(sizeof(SecondaryPageTable));
+static SecondaryPageTable* allocateSecondaryPageTable(Arena* arena) {
+    SecondaryPageTable* spt = (SecondaryPageTable*)arenaAlloc(arena, sizeof(SecondaryPageTable));
     if (!spt) return NULL;
 
-    spt->entries = (PageTableEntry*)malloc(numEntries * sizeof(PageTableEntry));
-    if (!spt->entries) {
-        free(spt);
-        return NULL;
-    }
-
-    spt->size = memorySize;
-    for (int i = 0; i < numEntries; ++i) {
-        spt->entries[i].frame_num = -1; // Initially, no frame is allocated
-        spt->entries[i].is_valid = false; // Mark as invalid initially
-        for (int j = 0; j < PAGE_SIZE / KB; ++j) {
-            spt->entries[i].chunks[j] = -1; // Mark all chunks as unallocated
-        }
+    spt->valid_count = 0;
+    for (int i = 0; i < ENTRIES_PER_TABLE; ++i) {
+        spt->entries[i] = PTE_EMPTY; // Initially invalid, with no frame allocated and no chunks in use
+        spt->page_nums[i] = -1;
     }
     return spt;
 }
 
-// Function to find and allocate a page in virtual memory, returning the page ID
-int allocatePage(VirtualMemory* vm) {
-    for (int i = 0; i < NUM_PAGES; i++) {
-        if (!vm->pages[i].is_allocated) {
-            vm->pages[i].is_allocated = true;
-            return i; // Return the ID of the allocated page
+// Function to find the SecondaryPageTable mapping vpn, allocating it and any missing PageDirectories on the way
+SecondaryPageTable* findOrCreatePageTable(MasterPageTable* mpt, long long vpn) {
+    PageDirectory* dir = mpt->root;
+    for (int level = PAGE_TABLE_LEVELS - 1; level > 1; level--) {
+        void** slot = &dir->entries[PAGE_TABLE_INDEX(vpn, level)];
+        if (*slot == NULL) {
+            *slot = arenaCalloc(&mpt->arena, sizeof(PageDirectory));
+            if (*slot == NULL) return NULL;
+            mpt->directories++;
         }
+        dir = *slot;
     }
-    return -1; // Indicate failure to allocate a page
-}
 
-// Function to allocate chunks within a given page and mark them as allocated
-void allocateChunksInPage(VirtualMemory* vm, int pageID, int chunksNeeded, PageTableEntry* entry) {
-    Page* page = &vm->pages[pageID];
-    int chunkIndex = 0;
-    for (int i = 0; i < chunksNeeded && i < PAGE_SIZE / CHUNK_SIZE; i++) {
-        if (!page->chunks[i].is_allocated) {
-            page->chunks[i].is_allocated = true;
-            entry->chunks[chunkIndex++] = i; // Assign chunk ID and increment chunkIndex
-        }
+    void** slot = &dir->entries[PAGE_TABLE_INDEX(vpn, 1)];
+    if (*slot == NULL) {
+        *slot = allocateSecondaryPageTable(&mpt->arena);
+        if (*slot == NULL) return NULL;
+        mpt->count++;
     }
+    return *slot;
 }
 
-// Function to create a process and allocate memory for it in virtual memory
-Process* create_process(int id, int memory_size, VirtualMemory* vm) {
-    if (!vm || memory_size <= 0 || memory_size > vm->remaining_memory) {
-        printf("\nInsufficient virtual memory to create process.\n");
-        return NULL;
+// Function to allocate a page in virtual memory, reusing freed pages before untouched ones, returning the page ID
+long long allocatePage(VirtualMemory* vm) {
+    long long pageID;
+    if (vm->free_count > 0) {
+        pageID = vm->free_pages[--vm->free_count];
+    } else if (growVirtualMemory(vm, vm->next_page + 1) == 0) {
+        pageID = vm->next_page++;
+    } else {
+        return -1; // Indicate failure to allocate a page
     }
+    vm->allocated_pages[pageID / 64] |= 1ULL << (pageID % 64);
+    return pageID; // Return the ID of the allocated page
+}
 
-    Process* process = (Process*)malloc(sizeof(Process));
-    if (!process) return NULL;
+// Function to allocate `count` pages in virtual memory in one pass, storing their IDs in pageIDs.
+// Either all pages are allocated and count is returned, or none are and -1 is returned.
+long long allocatePages(VirtualMemory* vm, long long count, long long* pageIDs) {
+    if (count < 0 || count > vm->free_count + (vm->config.num_pages - vm->next_page)) return -1;
+    if (count > vm->free_count && growVirtualMemory(vm, vm->next_page + (count - vm->free_count)) != 0) return -1;
 
-    process->id = id;
-    process->memory_size = memory_size;
-    vm->remaining_memory -= memory_size; // Deduct the allocated memory from the remaining virtual memory
-
-    int numSecondaryTables = (memory_size + SECONDARY_TABLE_SIZE - 1) / SECONDARY_TABLE_SIZE;
-    process->mpt = (MasterPageTable*)malloc(sizeof(MasterPageTable));
-    if (!process->mpt) {
-        free(process);
-        return NULL;
+    for (long long i = 0; i < count; i++) {
+        long long pageID = vm->free_count > 0 ? vm->free_pages[--vm->free_count] : vm->next_page++;
+        vm->allocated_pages[pageID / 64] |= 1ULL << (pageID % 64);
+        pageIDs[i] = pageID;
     }
+    return count;
+}
 
-    process->mpt->tables = (SecondaryPageTable**)malloc(numSecondaryTables * sizeof(SecondaryPageTable*));
-    process->mpt->count = numSecondaryTables;
+// Function to allocate chunks within a given page and mark them as allocated
+void allocateChunksInPage(VirtualMemory* vm, long long pageID, int chunksNeeded, PageTableEntry* entry) {
+    if (chunksNeeded <= 0) return;
+    if (chunksNeeded > vm->config.chunks_per_page) chunksNeeded = vm->config.chunks_per_page;
+
+    // The first chunksNeeded chunks of the page, recorded in both the page's chunk mask and the entry's chunk mask
+    unsigned int wanted = (1u << chunksNeeded) - 1;
+    vm->allocated_chunks[pageID] |= wanted;
+    pteSetChunkMask(entry, pteChunkMask(*entry) | wanted);
+}
+
+// Function to move a process's slab object into a page of its own, e.g. when the process grows past the object.
+// The new page is not resident yet; its chunk mask is left for the caller to fill in.
+static int moveSlabObjectToPage(Process* process, long long vpn, SecondaryPageTable* spt, int index, VirtualMemory* vm) {
+    long long pageID = allocatePage(vm);
+    if (pageID == -1) return -1;
+
+    PageTableEntry* entry = &spt->entries[index];
+    slabFree(pteFrame(*entry), pteChunkMask(*entry), vm);
+    tlbInvalidatePage(process->id, vpn);
+    spt->page_nums[index] = pageID;
+    *entry = PTE_EMPTY | PTE_VALID | (*entry & PTE_PROT_MASK);
+    return 0;
+}
 
-    // allocate PageTableEntries
-    int remaining_memory = memory_size;
-    for (int i = 0; i < numSecondaryTables; ++i) {
-        int tableSize = (i < numSecondaryTables - 1) ? SECONDARY_TABLE_SIZE : memory_size - i * SECONDARY_TABLE_SIZE;
-        process->mpt->tables[i] = allocateSecondaryPageTable(tableSize);
+// Function to give a process the virtual pages backing bytes [start, end) of its address space.
+// Pages that already belong to the process only get the chunks of the range they now also cover.
+// A new last page needing at most half of its chunks is an object of a shared slab page instead of a page of its own.
+// Returns the number of pages added, or -1 if virtual memory or page table memory ran out.
+static long long reserveProcessPages(Process* process, long long start, long long end, VirtualMemory* vm) {
+    const MemoryConfig* config = &vm->config;
+    long long firstVpn = start >> config->page_shift;
+    long long lastVpn = (end + config->page_mask) >> config->page_shift; // One past the last page
+    long long pagesAdded = 0;
+
+    // The last page goes to a slab if it is new and small enough; the loop below then stops short of it
+    long long tailVpn = lastVpn - 1;
+    int tailChunks = (end - (tailVpn << config->page_shift) + config->chunk_size - 1) >> config->chunk_shift;
+    if (tailVpn >= firstVpn && slabSizeClass(tailChunks, config) != -1) {
+        SecondaryPageTable* spt = findOrCreatePageTable(process->mpt, tailVpn);
+        if (spt == NULL) return -1;
+        int index = PAGE_TABLE_INDEX(tailVpn, 0);
+        long long pageID;
+        int frameID;
+        unsigned int chunkMask;
+        if (!(spt->entries[index] & PTE_VALID) && slabAllocate(tailChunks, vm, &pageID, &frameID, &chunkMask) == 0) {
+            PageTableEntry* entry = &spt->entries[index];
+            *entry = PTE_EMPTY | PTE_VALID | PTE_SLAB | PTE_PROT_READ | PTE_PROT_WRITE;
+            pteSetFrame(entry, frameID); // Slab pages are always resident
+            pteSetChunkMask(entry, chunkMask);
+            spt->page_nums[index] = pageID;
+            spt->valid_count++;
+            process->touched_pages++;
+            pagesAdded++;
+            lastVpn = tailVpn;
+        }
+    }
 
-        int remaining_process_size = tableSize; // Memory remaining to be allocated in this secondary table
-        int allocated_memory = 0; // Track allocated memory in the current secondary table
+    // reserve the virtual pages one SecondaryPageTable at a time, in a single pass per table
+    long long pageIDs[ENTRIES_PER_TABLE];
+    for (long long vpn = firstVpn; vpn < lastVpn; ) {
+        SecondaryPageTable* spt = findOrCreatePageTable(process->mpt, vpn);
+        if (spt == NULL) return -1;
 
-        // Calculate the number of pages (PageTableEntries) needed for this SecondaryPageTable
-        int numPagesNeeded = (tableSize + PAGE_SIZE - 1) / PAGE_SIZE;
+        int firstEntry = PAGE_TABLE_INDEX(vpn, 0);
+        int numEntries = ENTRIES_PER_TABLE - firstEntry;
+        if (numEntries > lastVpn - vpn) numEntries = lastVpn - vpn;
 
-        for (int pageIndex = 0; pageIndex < numPagesNeeded && remaining_process_size > 0; ++pageIndex) {
-            int pageID = allocatePage(vm);
-            if (pageID == -1) {
-                printf("Failed to allocate enough virtual memory for the process.\n");
-                return NULL;
+        int newPages = 0;
+        for (int i = firstEntry; i < firstEntry + numEntries; i++) {
+            newPages += !(spt->entries[i] & PTE_VALID);
+        }
+        if (allocatePages(vm, newPages, pageIDs) == -1) return -1;
+
+        int nextPage = 0;
+        for (int i = firstEntry; i < firstEntry + numEntries; i++, vpn++) {
+            PageTableEntry* entry = &spt->entries[i];
+            if (!(*entry & PTE_VALID)) {
+                // Initialize PageTableEntry for the current page
+                spt->page_nums[i] = pageIDs[nextPage++]; // Set the page number
+                *entry = PTE_EMPTY | PTE_VALID | PTE_PROT_READ | PTE_PROT_WRITE; // Valid, but no physical frame is allocated yet
+                spt->valid_count++;
+                process->touched_pages++;
             }
 
-            // Initialize PageTableEntry for the current page
-            PageTableEntry* entry = &process->mpt->tables[i]->entries[pageIndex];
-            entry->page_num = pageID; // Set the page number
-            entry->frame_num = -1; // Assuming no physical frame is allocated yet
-            entry->is_valid = true; // Mark as valid since we're allocating memory for it
+            // Calculate how many chunks of this page the range covers
+            long long pageStart = vpn << config->page_shift;
+            long long pageEnd = pageStart + config->page_size;
+            long long bytesInPage = (end < pageEnd ? end : pageEnd) - pageStart;
+            int chunksNeeded = (bytesInPage + config->chunk_size - 1) >> config->chunk_shift;
 
-            // Calculate how many chunks are needed for this secondary table
-            int chunksNeeded = tableSize / CHUNK_SIZE + (tableSize % CHUNK_SIZE != 0);
+            // A slab object that no longer holds the page's chunks moves to a page of its own
+            if (*entry & PTE_SLAB) {
+                if (chunksNeeded <= __builtin_popcount(pteChunkMask(*entry))) continue;
+                if (moveSlabObjectToPage(process, vpn, spt, i, vm) == -1) return -1;
+            }
 
             // Allocate chunks within the allocated page
-            allocateChunksInPage(vm, pageID, chunksNeeded, entry);
-            chunksNeeded -= PAGE_SIZE / CHUNK_SIZE; // Update the number of chunks needed
-
-            // Update remaining_memory
-            remaining_memory -= PAGE_SIZE;
-            if (remaining_memory <= 0) break; // Stop if we've allocated enough memory
+            allocateChunksInPage(vm, spt->page_nums[i], chunksNeeded, entry);
         }
-
+        pagesAdded += newPages;
     }
-
-    printf("\nProcess %d created successfully with %d bytes of memory.\n", id, memory_size);
-    return process;
+    return pagesAdded;
 }
 
-Process* findProcessById(int pid) {
-    Process* selectedProcess = NULL;
-    for (int i = 0; i < processCount; i++) {
-        if (processes[i]->id == pid) {
-            selectedProcess = processes[i];
-            break; // Exit the loop once the process is found
-        }
+// Function to create a process and allocate memory for it in virtual memory
+Process* create_process(int id, long long memory_size, VirtualMemory* vm) {
+    if (!vm) return NULL;
+    long long numPages = (memory_size + vm->config.page_mask) >> vm->config.page_shift;
+    if (memory_size <= 0 || memory_size > vm->remaining_memory || numPages > MAX_VPN) {
+        printf("\nInsufficient virtual memory to create process.\n");
+        return NULL;
     }
-    return selectedProcess; // Return the found process or NULL if not found
+
+    // The process, its MasterPageTable and its page tables share one arena.
+    // Only the root directory is allocated up front: the rest of the tree, and the virtual pages behind it, are
+    // reserved a SecondaryPageTable region at a time when the process first touches a page of the region.
+    Arena arena;
+    arenaInit(&arena);
+    Process* process = (Process*)arenaAlloc(&arena, sizeof(Process));
+    MasterPageTable* mpt = (MasterPageTable*)arenaAlloc(&arena, sizeof(MasterPageTable));
+    PageDirectory* root = (PageDirectory*)arenaCalloc(&arena, sizeof(PageDirectory));
+    if (!process || !mpt || !root) {
+        arenaRelease(&arena);
+        return NULL;
+    }
+
+    process->id = id;
+    process->memory_size = memory_size;
+    process->resident_pages = 0;
+    process->touched_pages = 0;
+    process->huge_pages = vm->config.huge_pages;
+    process->mpt = mpt;
+    process->vm = vm;
+    process->attachments = NULL;
+    process->readahead = (Readahead){ .last_fault = -1, .next_fault = -1, .window = READAHEAD_MIN_WINDOW };
+    mpt->root = root;
+    mpt->directories = 1;
+    mpt->count = 0;
+    mpt->arena = arena; // From here on the tree grows through the arena inside the MasterPageTable
+    vm->remaining_memory -= memory_size; // Deduct the allocated memory from the remaining virtual memory
+
+    TRACE_EVENT(EVENT_LEVEL_LIFECYCLE, EVENT_CREATE, id, numPages, -1);
+    return process;
 }
 
-// Helper function to print the chunks array for a PageTableEntry
-void printChunks(const int chunks[], int size) {
+// Helper function to print the chunks in use by a PageTableEntry, decoded from its chunk mask
+void printChunks(PageTableEntry entry) {
+    unsigned int chunkMask = pteChunkMask(entry);
     printf("[");
-    for (int i = 0; i < size; i++) {
-        if (chunks[i] != -1) { // Assuming -1 indicates an unused slot in the array
-            printf("%d", chunks[i]);
-            if (i < size - 1 && chunks[i + 1] != -1) {
-                printf(", ");
-            }
+    for (int i = 0; i < MAX_CHUNKS_PER_PAGE; i++) {
+        if (chunkMask & (1u << i)) {
+            chunkMask &= ~(1u << i);
+            printf("%d%s", i, chunkMask ? ", " : "");
         }
     }
     printf("]");
@@ -158,25 +258,42 @@ void printProcess(const Process* process) {
 
     printf("Process {\n");
     printf("    id: %d,\n", process->id);
-    printf("    memory_size: %d bytes,\n", process->memory_size);
+    printf("    memory_size: %lld bytes,\n", process->memory_size);
     printf("    MasterPageTable {\n");
+    printf("        directories: %lld,\n", process->mpt->directories);
+    printf("        arena: %zu bytes in use of %zu reserved,\n", process->mpt->arena.allocated, process->mpt->arena.reserved);
 
-    for (int i = 0; i < process->mpt->count; i++) {
+    long long base = 0;
+    SecondaryPageTable* spt;
+    for (int i = 0; (spt = nextPageTable(process->mpt, &base)) != NULL; i++, base += ENTRIES_PER_TABLE) {
         printf("        %d: SecondaryPageTable {\n", i + 1);
+        PageTableEntry* huge = lookupHugePageEntry(process, base);
+        if (huge != NULL) {
+            printf("            huge page: frames %d-%d,\n", pteFrame(*huge), pteFrame(*huge) + HUGE_PAGE_FRAMES - 1);
+        }
         printf("            entries: [\n");
-        for (int j = 0; j < process->mpt->tables[i]->size / PAGE_SIZE; j++) { // Adjust based on actual structure and needs
+        int printed = 0;
+        for (int j = 0; j < ENTRIES_PER_TABLE; j++) {
+            PageTableEntry entry = spt->entries[j];
+            if (!(entry & PTE_VALID)) continue; // Not part of the process
             printf("                {\n");
-            printf("                    page_num: %d,\n", process->mpt->tables[i]->entries[j].page_num);
-            printf("                    frame_num: %d,\n", process->mpt->tables[i]->entries[j].frame_num);
-            printf("                    is_valid: %s,\n", process->mpt->tables[i]->entries[j].is_valid ? "true" : "false");
+            printf("                    vpn: %lld,\n", base + j);
+            printf("                    page_num: %lld,\n", spt->page_nums[j]);
+            printf("                    frame_num: %d,\n", pteFrame(entry));
+            printf("                    is_valid: %s,\n", (entry & PTE_VALID) ? "true" : "false");
+            printf("                    referenced: %s,\n", (entry & PTE_REFERENCED) ? "true" : "false");
+            printf("                    dirty: %s,\n", (entry & PTE_DIRTY) ? "true" : "false");
+            printf("                    swapped: %s,\n", (entry & PTE_SWAPPED) ? "true" : "false");
+            printf("                    protection: %c%c%c,\n", (entry & PTE_PROT_READ) ? 'r' : '-',
+                   (entry & PTE_PROT_WRITE) ? 'w' : '-', (entry & PTE_PROT_EXEC) ? 'x' : '-');
             printf("                    chunks: ");
-            printChunks(process->mpt->tables[i]->entries[j].chunks, PAGE_SIZE / KB);
+            printChunks(entry);
             printf("\n                }");
-            if (j < process->mpt->tables[i]->size / PAGE_SIZE - 1) printf(",");
+            if (++printed < spt->valid_count) printf(",");
             printf("\n");
         }
         printf("            ],\n");
-        printf("            size: %d bytes\n", process->mpt->tables[i]->size);
+        printf("            valid entries: %d\n", spt->valid_count);
         printf("        },\n");
     }
 
@@ -184,290 +301,905 @@ void printProcess(const Process* process) {
     printf("}\n");
 }
 
+// Function to find the level 1 PageDirectory on the path to vpn, or NULL if the path is not allocated
+static PageDirectory* findLeafDirectory(const MasterPageTable* mpt, long long vpn) {
+    PageDirectory* dir = mpt->root;
+    for (int level = PAGE_TABLE_LEVELS - 1; level > 1 && dir != NULL; level--) {
+        dir = dir->entries[PAGE_TABLE_INDEX(vpn, level)];
+    }
+    return dir;
+}
+
+// Function to look up the PageTableEntry of a per-process virtual page number.
+// Each level's bits of the VPN index one PageDirectory on the way down to the SecondaryPageTable,
+// so the lookup is PAGE_TABLE_LEVELS array dereferences. Returns NULL if no table maps the VPN.
+PageTableEntry* lookupPageTableEntry(const Process* process, long long vpn) {
+    if (!process || vpn < 0 || vpn >= MAX_VPN) return NULL;
+
+    PageDirectory* dir = findLeafDirectory(process->mpt, vpn);
+    if (dir == NULL) return NULL;
+
+    SecondaryPageTable* spt = dir->entries[PAGE_TABLE_INDEX(vpn, 1)];
+    if (spt == NULL) return NULL;
+    return &spt->entries[PAGE_TABLE_INDEX(vpn, 0)];
+}
+
+long long lookupPageId(const Process* process, long long vpn) {
+    if (!process || vpn < 0 || vpn >= MAX_VPN) return -1;
+
+    PageDirectory* dir = findLeafDirectory(process->mpt, vpn);
+    SecondaryPageTable* spt = dir ? dir->entries[PAGE_TABLE_INDEX(vpn, 1)] : NULL;
+    return spt ? spt->page_nums[PAGE_TABLE_INDEX(vpn, 0)] : -1;
+}
+
+PageTableEntry* lookupHugePageEntry(const Process* process, long long vpn) {
+    if (!process || vpn < 0 || vpn >= MAX_VPN) return NULL;
+
+    PageDirectory* dir = findLeafDirectory(process->mpt, vpn);
+    if (dir == NULL || dir->huge_entries == NULL) return NULL;
+
+    PageTableEntry* entry = &dir->huge_entries[PAGE_TABLE_INDEX(vpn, 1)];
+    return (*entry & PTE_PRESENT) ? entry : NULL;
+}
+
+// Function to find the PageTableEntry of a page of the process, first reserving the pages of the page's
+// SecondaryPageTable region if this is the first touch of the region. Returns NULL if vpn is past the end of
+// the process or the region's pages could not be reserved.
+static PageTableEntry* touchPageTableEntry(Process* process, long long vpn) {
+    PageTableEntry* entry = lookupPageTableEntry(process, vpn);
+    if (entry != NULL && (*entry & PTE_VALID)) return entry;
+
+    const MemoryConfig* config = &process->vm->config;
+    if (vpn < 0 || vpn >= (process->memory_size + config->page_mask) >> config->page_shift) return NULL;
+
+    long long regionStart = (vpn & ~(long long)PAGE_TABLE_INDEX_MASK) << config->page_shift;
+    long long regionEnd = regionStart + ((long long)ENTRIES_PER_TABLE << config->page_shift);
+    if (regionEnd > process->memory_size) regionEnd = process->memory_size;
+    if (reserveProcessPages(process, regionStart, regionEnd, process->vm) == -1) return NULL;
+    return lookupPageTableEntry(process, vpn);
+}
+
+// Function to find the first SecondaryPageTable below dir mapping a VPN at or after *vpn; base is the first VPN dir maps
+static SecondaryPageTable* findPageTableFrom(PageDirectory* dir, int level, long long base, long long* vpn) {
+    int shift = level * PAGE_TABLE_INDEX_BITS;
+    int first = *vpn > base ? (int)((*vpn - base) >> shift) : 0;
+    for (int i = first; i < ENTRIES_PER_TABLE; i++) {
+        if (dir->entries[i] == NULL) continue; // Nothing mapped below this entry
+        long long childBase = base + ((long long)i << shift);
+        if (level == 1) {
+            *vpn = childBase;
+            return dir->entries[i];
+        }
+        SecondaryPageTable* spt = findPageTableFrom(dir->entries[i], level - 1, childBase, vpn);
+        if (spt != NULL) return spt;
+    }
+    return NULL;
+}
+
+SecondaryPageTable* nextPageTable(const MasterPageTable* mpt, long long* vpn) {
+    if (*vpn < 0 || *vpn >= MAX_VPN) return NULL;
+    return findPageTableFrom(mpt->root, PAGE_TABLE_LEVELS - 1, 0, vpn);
+}
+
 int findFreeFrame(PhysicalMemory* pm) {
-    for (int i = 0; i < NUM_FRAMES; i++) {
-        if (!pm->frames[i].is_allocated) {
-            return i;
+    return findFirstFreeFrame(pm); // -1 if physical memory is full
+}
+
+// Function to drop a page's reference to its frame: the frame is freed once no page maps it any more
+void releaseFrame(Process* process, long long vpn, int frameID, PhysicalMemory* pm) {
+    if (pm->ref_counts[frameID] > 1) {
+        pm->ref_counts[frameID]--; // Still mapped by a forked process
+        replacementOnUnshare(frameID, process, vpn);
+    } else {
+        freePhysicalFrame(frameID, pm);
+    }
+}
+
+// Function to map a single page of a process to a free frame, evicting a page if physical memory is full.
+// Returns the frame ID, or -1 if no frame could be found or the page could not be read back from swap.
+static int mapPageToFrame(Process* process, long long vpn, PageTableEntry* entry, PhysicalMemory* pm) {
+    cleanDirtyPages(pm); // While memory is nearly full, write dirty pages out before they are chosen as victims
+
+    int frameID = allocateFrameBlock(pm, 0); // A single frame is an order 0 buddy block; -1 if none is free
+    if (frameID == -1 && evictPage(pm) != -1) {
+        frameID = allocateFrameBlock(pm, 0); // Physical memory was full: the replacement policy made room
+    }
+    if (frameID == -1) return -1;
+
+    // Read the page back if it was swapped out. A shared segment page may have been swapped out by another process.
+    // If the slot cannot be read (counted in SwapStats.read_errors), the page stays swapped out and the fault fails.
+    if ((*entry & (PTE_SWAPPED | PTE_SHARED)) && swapIn(lookupPageId(process, vpn)) == -1) {
+        freeFrameBlock(pm, frameID, 0);
+        return -1;
+    }
+    *entry &= ~PTE_SWAPPED;
+
+    pteSetFrame(entry, frameID);
+    replacementOnMap(frameID, process, vpn);
+    process->resident_pages++;
+    TRACE_EVENT(EVENT_LEVEL_PAGING, EVENT_MAP, process->id, vpn, frameID);
+
+    // Copy chunk allocation details to the physical frame
+    pm->allocated_chunks[frameID] = pteChunkMask(*entry);
+    return frameID;
+}
+
+// Function to map the whole region of vpn to HUGE_PAGE_FRAMES contiguous frames with a huge-page entry.
+// Only regions whose pages all belong to the process and none of which is resident qualify; no page is evicted
+// to make room. Returns the frame of vpn, or -1 if the caller should map the single page instead.
+static int mapHugePage(Process* process, long long vpn, PhysicalMemory* pm) {
+    PageDirectory* dir = findLeafDirectory(process->mpt, vpn);
+    SecondaryPageTable* spt = dir->entries[PAGE_TABLE_INDEX(vpn, 1)];
+    if (spt->valid_count != ENTRIES_PER_TABLE) return -1;
+    for (int i = 0; i < ENTRIES_PER_TABLE; i++) {
+        // Shared segment pages have frames of their own, and swapped out pages must be read back one by one
+        if (spt->entries[i] & (PTE_PRESENT | PTE_SHARED | PTE_SWAPPED)) return -1;
+    }
+
+    if (dir->huge_entries == NULL) {
+        dir->huge_entries = arenaAlloc(&process->mpt->arena, ENTRIES_PER_TABLE * sizeof(PageTableEntry));
+        if (dir->huge_entries == NULL) return -1;
+        for (int i = 0; i < ENTRIES_PER_TABLE; i++) dir->huge_entries[i] = PTE_EMPTY;
+    }
+
+    int firstFrame = allocateFrameBlock(pm, HUGE_PAGE_ORDER); // Aligned to the huge page size
+    if (firstFrame == -1) {
+        hugePageStats.fallbacks++; // Physical memory is too fragmented or too full
+        return -1;
+    }
+
+    long long baseVpn = vpn & ~(long long)PAGE_TABLE_INDEX_MASK;
+    for (int i = 0; i < HUGE_PAGE_FRAMES; i++) {
+        pm->allocated_chunks[firstFrame + i] = pteChunkMask(spt->entries[i]);
+        replacementOnMap(firstFrame + i, process, baseVpn + i);
+    }
+
+    PageTableEntry* huge = &dir->huge_entries[PAGE_TABLE_INDEX(vpn, 1)];
+    *huge = PTE_EMPTY | PTE_VALID | PTE_HUGE | PTE_PROT_READ | PTE_PROT_WRITE;
+    pteSetFrame(huge, firstFrame);
+    process->resident_pages += HUGE_PAGE_FRAMES;
+    hugePageStats.mappings++;
+    TRACE_EVENT(EVENT_LEVEL_PAGING, EVENT_MAP, process->id, baseVpn, firstFrame);
+    return firstFrame + PAGE_TABLE_INDEX(vpn, 0);
+}
+
+// Function to map a single page of a process to a frame. A shared segment page maps the frame the segment page is
+// resident in, if another process has faulted it in; otherwise a new frame, which becomes the segment page's.
+// Returns the frame ID, or -1 if no frame could be found.
+static int mapPage(Process* process, long long vpn, PageTableEntry* entry, PhysicalMemory* pm) {
+    if (!(*entry & PTE_SHARED)) return mapPageToFrame(process, vpn, entry, pm);
+
+    int frameID = segmentFrame(process, vpn);
+    if (frameID != -1 && replacementOnShare(frameID, process, vpn) == 0) {
+        pm->ref_counts[frameID]++;
+        pteSetFrame(entry, frameID);
+        *entry &= ~PTE_SWAPPED; // Another process read the page back
+        process->resident_pages++;
+        TRACE_EVENT(EVENT_LEVEL_PAGING, EVENT_MAP, process->id, vpn, frameID);
+        return frameID;
+    }
+    if (frameID != -1) return -1; // The reverse map entry could not be allocated
+
+    frameID = mapPageToFrame(process, vpn, entry, pm);
+    if (frameID != -1) segmentSetFrame(process, vpn, frameID);
+    return frameID;
+}
+
+void splitHugePage(Process* process, long long vpn, PhysicalMemory* pm) {
+    PageTableEntry* huge = lookupHugePageEntry(process, vpn);
+    if (huge == NULL) return;
+
+    // Hand every page of the region its own frame of the huge page; the frames stay where they are
+    SecondaryPageTable* spt = findLeafDirectory(process->mpt, vpn)->entries[PAGE_TABLE_INDEX(vpn, 1)];
+    int firstFrame = pteFrame(*huge);
+    for (int i = 0; i < ENTRIES_PER_TABLE; i++) {
+        if (spt->entries[i] & PTE_VALID) {
+            pteSetFrame(&spt->entries[i], firstFrame + i);
+        } else {
+            freePhysicalFrame(firstFrame + i, pm); // The page left the process while the huge page was mapped
+            process->resident_pages--;
         }
     }
-    return -1; // Indicate failure to find a free frame
+    *huge = PTE_EMPTY;
+    tlbInvalidatePage(process->id, vpn); // Drops the huge-page translation
+    hugePageStats.splits++;
 }
 
 void allocatePagesToPhysicalMemory(Process* process, PhysicalMemory* pm) {
     if (!process || !pm) return;
 
-    for (int i = 0; i < process->mpt->count; i++) { // Iterate through secondary page tables
-        SecondaryPageTable* spt = process->mpt->tables[i];
-        for (int j = 0; j < (spt->size + PAGE_SIZE - 1) / PAGE_SIZE; j++) { // Iterate through page table entries
+    // Every region of the process is touched, so reserve the pages of the regions that have not been yet
+    long long numPages = (process->memory_size + pm->config.page_mask) >> pm->config.page_shift;
+    for (long long vpn = 0; vpn < numPages; vpn += ENTRIES_PER_TABLE) {
+        touchPageTableEntry(process, vpn);
+    }
+
+    long long base = 0;
+    SecondaryPageTable* spt;
+    while ((spt = nextPageTable(process->mpt, &base)) != NULL) { // Iterate through secondary page tables
+        if (lookupHugePageEntry(process, base) != NULL
+            || (process->huge_pages && mapHugePage(process, base, pm) != -1)) {
+            base += ENTRIES_PER_TABLE; // The whole table is resident in a huge page
+            continue;
+        }
+        for (int j = 0; j < ENTRIES_PER_TABLE; j++) { // Iterate through page table entries
             PageTableEntry* entry = &spt->entries[j];
-            if (entry->is_valid) {
-                int frameID = findFreeFrame(pm); // This function finds a free frame and returns its ID, -1 if none found
-                if (frameID != -1) {
-                    entry->frame_num = frameID;
-                    pm->frames[frameID].is_allocated = true; // Mark frame as allocated
-                    // Copy chunk allocation details to the physical frame
-                    for (int chunk = 0; chunk < PAGE_SIZE / KB; chunk++) {
-                        if (entry->chunks[chunk] != -1) {
-                            pm->frames[frameID].chunks[chunk].is_allocated = true;
-                        }
-                    }
-                }
+            if ((*entry & PTE_VALID) && !(*entry & PTE_PRESENT)) {
+                mapPage(process, base + j, entry, pm);
             }
         }
+        base += ENTRIES_PER_TABLE;
+    }
+}
+
+// Function to follow the fault stream of a process after a fault on vpn, and to map the next pages of the stream
+// ahead of their faults once the stream is established (see Readahead). Pages are prefetched like faulted pages,
+// evicting others if physical memory is full, but are not entered in the TLB.
+static void readahead(Process* process, long long vpn, PhysicalMemory* pm) {
+    Readahead* ra = &process->readahead;
+    long long stride = vpn - ra->last_fault;
+    bool continued = vpn == ra->next_fault; // The stream used every page prefetched for it
+    if (continued) {
+        if (ra->window < READAHEAD_MAX_WINDOW) {
+            ra->window = 2 * ra->window < READAHEAD_MAX_WINDOW ? 2 * ra->window : READAHEAD_MAX_WINDOW;
+            readaheadStats.window_grows++;
+        }
+    } else if (ra->last_fault != -1 && stride == ra->stride && stride != 0 && llabs(stride) <= READAHEAD_MAX_STRIDE) {
+        ra->streak++;
+    } else {
+        ra->stride = stride;
+        ra->streak = ra->last_fault == -1 ? 1 : 2;
+        ra->next_fault = -1;
+    }
+    ra->last_fault = vpn;
+    if (!continued && ra->streak < READAHEAD_MIN_STREAK) return;
+
+    const MemoryConfig* config = &process->vm->config;
+    long long pages = (process->memory_size + config->page_mask) >> config->page_shift;
+    long long target = vpn;
+    int prefetched = 0;
+    for (int i = 0; i < ra->window; i++) {
+        target += ra->stride;
+        if (target < 0 || target >= pages) break;
+        PageTableEntry* entry = touchPageTableEntry(process, target);
+        if (entry == NULL) break;
+        if (!(*entry & PTE_VALID) || (*entry & PTE_PRESENT) || lookupHugePageEntry(process, target) != NULL) continue;
+        if (mapPage(process, target, entry, pm) == -1) break;
+        *entry |= PTE_PREFETCHED;
+        prefetched++;
+    }
+    ra->next_fault = target + ra->stride;
+    if (prefetched > 0) {
+        readaheadStats.readaheads++;
+        readaheadStats.prefetched += prefetched;
+    }
+}
+
+// Function to count a prefetched page that is unmapped before it is accessed
+void readaheadOnUnmap(Process* process, PageTableEntry* entry) {
+    if (!(*entry & PTE_PREFETCHED)) return;
+    *entry &= ~PTE_PREFETCHED;
+    readaheadStats.wasted++;
+    if (process->readahead.window > READAHEAD_MIN_WINDOW) {
+        process->readahead.window /= 2;
+        readaheadStats.window_shrinks++;
     }
+}
+
+// Function to resolve a page fault by mapping only the faulting page to a frame
+int handlePageFault(Process* process, long long vpn, PhysicalMemory* pm) {
+    PageTableEntry* entry = touchPageTableEntry(process, vpn);
+    if (entry == NULL || !(*entry & PTE_VALID)) return -1; // Not a page of the process
+    if (*entry & PTE_PRESENT) return pteFrame(*entry); // Already resident
 
-    // update remaining_memory
-    pm->remaining_memory = pm->remaining_memory - process->memory_size;
-    printf("\nPages allocated to physical memory for process %d.\n", process->id);
+    PageTableEntry* huge = lookupHugePageEntry(process, vpn);
+    if (huge != NULL) return pteFrame(*huge) + PAGE_TABLE_INDEX(vpn, 0); // Already resident in a huge page
+
+    page_faults++;  // Increment the global page_faults counter
+    int frameID = -1;
+    if (process->huge_pages) {
+        hugePageStats.faults++;
+        frameID = mapHugePage(process, vpn, pm); // Opportunistically map the whole region at once
+    }
+    if (frameID == -1) {
+        // Prefetch first, so that making room for the prefetched pages cannot evict the faulting page
+        if (process->vm->config.readahead) readahead(process, vpn, pm);
+        frameID = mapPage(process, vpn, entry, pm);
+    }
+    TRACE_EVENT(EVENT_LEVEL_PAGING, EVENT_FAULT, process->id, vpn, frameID);
+    return frameID;
 }
 
 void deallocatePagesFromPhysicalMemory(Process* process, PhysicalMemory* pm) {
     if (!process || !pm) return;
 
-    for (int i = 0; i < process->mpt->count; i++) { // Iterate through secondary page tables
-        SecondaryPageTable* spt = process->mpt->tables[i];
-        for (int j = 0; j < (spt->size + PAGE_SIZE - 1) / PAGE_SIZE; j++) { // Iterate through page table entries
+    long long base = 0;
+    SecondaryPageTable* spt;
+    while ((spt = nextPageTable(process->mpt, &base)) != NULL) { // Iterate through secondary page tables
+        splitHugePage(process, base, pm); // Unmap a huge page page by page like any other table
+        for (int j = 0; j < ENTRIES_PER_TABLE; j++) { // Iterate through page table entries
             PageTableEntry* entry = &spt->entries[j];
-            if (entry->frame_num != -1) {
-                // Clear the physical frame
-                Frame* frame = &pm->frames[entry->frame_num];
-                frame->is_allocated = false;
-                for (int chunk = 0; chunk < PAGE_SIZE / KB; chunk++) {
-                    frame->chunks[chunk].is_allocated = false;
-                }
-                // Reset PageTableEntry
-                entry->frame_num = -1;
-                for (int chunk = 0; chunk < PAGE_SIZE / KB; chunk++) {
-                    entry->chunks[chunk] = -1; // Clear chunk allocation details
-                }
+            if ((*entry & PTE_PRESENT) && !(*entry & PTE_SLAB)) { // Shared slab pages stay resident
+                TRACE_EVENT(EVENT_LEVEL_PAGING, EVENT_UNMAP, process->id, base + j, pteFrame(*entry));
+
+                readaheadOnUnmap(process, entry);
+
+                // A private page's contents are discarded, along with its copy in swap once no forked page shares
+                // the frame. A shared segment page belongs to the segment: its slot is kept for the other attached
+                // processes and freed with the segment (freeVirtualPage).
+                if (!(*entry & PTE_SHARED) && pm->ref_counts[pteFrame(*entry)] == 1) swapForgetPage(spt->page_nums[j]);
+
+                // Clear the physical frame and return it to the free-frame bitmap, unless a forked process shares it
+                releaseFrame(process, base + j, pteFrame(*entry), pm);
+                process->resident_pages--;
+                // Reset PageTableEntry; the chunk mask still describes the virtual page
+                pteSetFrame(entry, -1);
+                *entry &= ~(PTE_REFERENCED | PTE_DIRTY | PTE_COW);
             }
         }
+        base += ENTRIES_PER_TABLE;
     }
 
-    // update remaining_memory
-    pm->remaining_memory = pm->remaining_memory + process->memory_size;
-    printf("\nPages deallocated from physical memory for process %d.\n", process->id);
+    // Every cached translation of the process is now stale
+    tlbInvalidateProcess(process->id);
 }
 
-// Function to access a process's frame in physical memory
-int accessMemory(Process* process, int page_id) {
-    num_accesses++;  // Increment the number of memory access attempts
+// Function to find the frame of a valid page after a TLB miss, faulting the page in if it is not resident,
+// and to cache the translation in the TLB. A page in a huge page is translated by the huge-page entry and
+// cached as the whole huge page. Returns the frame, or -1 if the page fault could not be resolved.
+static int translatePage(Process* process, long long vpn, PageTableEntry* entry, PhysicalMemory* pm) {
+    if (process->huge_pages) hugePageStats.walks++;
 
-    // Iterate through the MasterPageTable to find the PageTableEntry for the given page_id
-    for (int i = 0; i < process->mpt->count; i++) {
-        SecondaryPageTable* spt = process->mpt->tables[i];
-        for (int j = 0; j < (spt->size + PAGE_SIZE - 1) / PAGE_SIZE; j++) {
-            PageTableEntry* entry = &spt->entries[j];
-            if (entry->page_num == page_id) {  // Found the corresponding PageTableEntry
-                if (entry->frame_num == -1) {  // Page fault occurs if frame_num is -1
-                    page_faults++;  // Increment the global page_faults counter
-                    printf("Page fault occurred for page ID %d in process ID %d.\n", page_id, process->id);
-                    return -1;
-                } else {
-                    // Successfully accessed the page in physical memory
-                    printf("Successfully accessed frame %d for page ID %d in process ID %d.\n", entry->frame_num, page_id, process->id);
-                }
-                return 0;  // Exit after handling the page access
-            }
+    if (*entry & PTE_PREFETCHED) {
+        *entry &= ~PTE_PREFETCHED; // Readahead mapped the page in time
+        readaheadStats.hits++;
+    }
+    if (!(*entry & PTE_PRESENT)) {
+        PageTableEntry* huge = process->huge_pages ? lookupHugePageEntry(process, vpn) : NULL;
+        if (huge == NULL) {
+            if (handlePageFault(process, vpn, pm) == -1) return -1;
+            if (!(*entry & PTE_PRESENT)) huge = lookupHugePageEntry(process, vpn); // The fault mapped the whole region
+        }
+        if (huge != NULL) {
+            hugePageStats.huge_walks++;
+            tlbInsertHuge(process->id, vpn, pteFrame(*huge), pteTlbProt(*huge));
+            return pteFrame(*huge) + PAGE_TABLE_INDEX(vpn, 0);
         }
     }
 
-    // If the page_id was not found in any PageTableEntry, it's considered an invalid access
-    printf("Invalid page ID %d access attempt in process ID %d.\n", page_id, process->id);
+    tlbInsert(process->id, vpn, pteFrame(*entry), pteTlbProt(*entry));
+    return pteFrame(*entry);
 }
 
-// Function to translate all virtual addresses of a process to physical addresses
-void translateVirtualToPhysicalAddress(PhysicalMemory* pm, char* virtualAddress, int processId) {
-    int pageId, offset;
-    char physicalAddress[20];       // Assuming this is large enough for the physical address format
+// Function to resolve a write to a copy-on-write page: a frame still shared with another process is copied to a
+// private frame (evicting a page if physical memory is full), and the page keeps a frame no longer shared.
+// Returns the page's frame, or -1 if no frame could be found for the copy or the page could not be read back from swap.
+static int breakCopyOnWrite(Process* process, long long vpn, PageTableEntry* entry, PhysicalMemory* pm) {
+    forkStats.cow_faults++;
+    int shared = pteFrame(*entry);
+    if (pm->ref_counts[shared] == 1) {
+        *entry &= ~PTE_COW; // The other processes have let go of the frame
+        return shared;
+    }
+
+    int frameID = allocateFrameBlock(pm, 0);
+    if (frameID == -1 && evictPage(pm) != -1) {
+        frameID = allocateFrameBlock(pm, 0); // Physical memory was full: the replacement policy made room
+    }
+    if (frameID == -1) return -1;
+
+    if (*entry & PTE_PRESENT) {
+        // Copy the page, and hand the shared frame over to the processes still mapping it
+        pm->ref_counts[shared]--;
+        replacementOnUnshare(shared, process, vpn);
+        tlbInvalidatePage(process->id, vpn);
+        forkStats.cow_copies++;
+    } else {
+        // Making room evicted the shared frame itself: the new frame simply backs the page, read back from swap
+        if ((*entry & PTE_SWAPPED) && swapIn(lookupPageId(process, vpn)) == -1) {
+            freeFrameBlock(pm, frameID, 0);
+            return -1;
+        }
+        process->resident_pages++;
+        *entry &= ~PTE_SWAPPED;
+    }
+    pteSetFrame(entry, frameID);
+    *entry &= ~PTE_COW;
+    pm->allocated_chunks[frameID] = pteChunkMask(*entry);
+    replacementOnMap(frameID, process, vpn);
+    tlbInsert(process->id, vpn, frameID, pteTlbProt(*entry));
+    TRACE_EVENT(EVENT_LEVEL_PAGING, EVENT_MAP, process->id, vpn, frameID);
+    return frameID;
+}
+
+// Function to access a process's frame in physical memory, faulting the page in if it is not resident
+int accessMemory(Process* process, long long vpn, bool isWrite, PhysicalMemory* pm) {
+    num_accesses++;  // Increment the number of memory access attempts
+    if (process->huge_pages) hugePageStats.translations++;
+
+    // Consult the TLB before walking the page tables; a hit is checked against the protection cached with it
+    int prot;
+    int frameNum = tlbLookup(process->id, vpn, &prot);
+    if (frameNum != -1) {
+        if (!(prot & (isWrite ? TLB_PROT_WRITE : TLB_PROT_READ))) return ACCESS_PROTECTION;
+        if (isWrite) {
+            // The dirty bit and copy-on-write state live in the PageTableEntry
+            PageTableEntry* entry = lookupPageTableEntry(process, vpn);
+            if ((*entry & PTE_COW) && (frameNum = breakCopyOnWrite(process, vpn, entry, pm)) == -1) return ACCESS_NO_FRAME;
+            *entry |= PTE_DIRTY;
+        }
+        replacementOnAccess(frameNum);
+        TRACE_EVENT(EVENT_LEVEL_ACCESS, EVENT_HIT, process->id, vpn, frameNum);
+        return frameNum;
+    }
+
+    // Index straight into the MasterPageTable to find the PageTableEntry for the given VPN,
+    // reserving the pages of its region on the first touch
+    PageTableEntry* entry = touchPageTableEntry(process, vpn);
+    if (entry == NULL || !(*entry & PTE_VALID)) {
+        return ACCESS_INVALID_PAGE; // The VPN is not part of the process
+    }
+    if (!(*entry & (isWrite ? PTE_PROT_WRITE : PTE_PROT_READ))) {
+        return ACCESS_PROTECTION;
+    }
+
+    // Page fault occurs if the page is not present; the translation is cached for the next access
+    frameNum = translatePage(process, vpn, entry, pm);
+    if (frameNum == -1) {
+        return ACCESS_NO_FRAME;
+    }
+
+    // The first write to a page shared with a forked process gives the page a frame of its own
+    if (isWrite && (*entry & PTE_COW)) {
+        frameNum = breakCopyOnWrite(process, vpn, entry, pm);
+        if (frameNum == -1) return ACCESS_NO_FRAME;
+    }
+
+    // Successfully accessed the page in physical memory. The page's own entry keeps its referenced and
+    // dirty bits even in a huge page, so the replacement policy and a later split see them per page.
+    *entry |= isWrite ? (PTE_REFERENCED | PTE_DIRTY) : PTE_REFERENCED;
+    replacementOnAccess(frameNum);
+    TRACE_EVENT(EVENT_LEVEL_ACCESS, EVENT_HIT, process->id, vpn, frameNum);
+    return frameNum;
+}
+
+// Function to translate a virtual address of a process to a physical address, faulting the page in if needed
+int translateVirtualToPhysicalAddress(PhysicalMemory* pm, const char* virtualAddress, int processId, char* physicalAddress) {
+    long long pageId;
+    int offset;
 
     // Validate and parse the virtual address
-    if (sscanf(virtualAddress, "0vp%ds%d", &pageId, &offset) != 2) {
-        printf("Invalid virtual address format.\n");
-        return;
+    if (sscanf(virtualAddress, "0vp%llds%d", &pageId, &offset) != 2 || offset < 0 || offset >= pm->config.page_size) {
+        return ACCESS_INVALID_ADDRESS;
     }
 
     Process* process = findProcessById(processId);
     if (!process) {
-        printf("Process with ID %d not found.\n", processId);
-        return;
+        return ACCESS_NO_PROCESS;
     }
+    if (process->huge_pages) hugePageStats.translations++;
 
-    // Lookup the page in the process's page table to find its frame number
-    int frameNum = -1;
-    for (int i = 0; i < process->mpt->count; i++) {
-        for (int j = 0; j < (process->mpt->tables[i]->size + PAGE_SIZE - 1) / PAGE_SIZE; j++) {
-            if (process->mpt->tables[i]->entries[j].page_num == pageId) {
-                frameNum = process->mpt->tables[i]->entries[j].frame_num;
-                break;
-            }
+    // Consult the TLB, then lookup the page in the process's page table to find its frame number
+    int frameNum = tlbLookup(processId, pageId, NULL);
+    if (frameNum == -1) {
+        PageTableEntry* entry = touchPageTableEntry(process, pageId);
+        if (entry == NULL || !(*entry & PTE_VALID)) {
+            return ACCESS_INVALID_PAGE;
+        }
+
+        // If the page is not present, it is not in physical memory: fault it in
+        frameNum = translatePage(process, pageId, entry, pm);
+        if (frameNum == -1) {
+            return ACCESS_NO_FRAME;
         }
-        if (frameNum != -1) break;
+        *entry |= PTE_REFERENCED;
     }
 
-    // If the frame number is -1, the page is not in physical memory
-    if (frameNum == -1) {
-        page_faults++;      // Assume entire process loading counts as one page fault for simplicity
-        printf("Page ID %d not found in physical memory for process ID %d.\n", pageId, processId);
-        printf("Do you want to allocate the page to physical memory? (y/n): ");
-        char choice;
-        scanf(" %c", &choice);
-        if (choice == 'y' || choice == 'Y') {
-            allocatePagesToPhysicalMemory(process, pm);
-        } else {
-            return;
+    // A slab object starts at its first chunk within the shared frame, and ends with its last one: the rest of the
+    // frame holds other processes' objects
+    PageTableEntry* entry = lookupPageTableEntry(process, pageId);
+    if (*entry & PTE_SLAB) {
+        if (offset >= __builtin_popcount(pteChunkMask(*entry)) << pm->config.chunk_shift) {
+            return ACCESS_INVALID_ADDRESS;
         }
+        offset += __builtin_ctz(pteChunkMask(*entry)) * pm->config.chunk_size;
+    }
+    replacementOnAccess(frameNum);
 
-        // Print the physical memory allocation after handling the page fault
-        printf("\nPhysical Memory after handling page fault:\n---------------------------");
-        printAllocatedFrameMemory(pm);
+    // Build the physical address for the given virtual address
+    sprintf(physicalAddress, "0pf%ds%d", frameNum, offset);
+    return frameNum;
+}
 
-        printf("\n");       // newline
-        // Print the physical address for the pages in the process
-        for (int i = 0; i < process->mpt->count; i++) {
-            for (int j = 0; j < (process->mpt->tables[i]->size + PAGE_SIZE - 1) / PAGE_SIZE; j++) {
-                if (process->mpt->tables[i]->entries[j].frame_num != -1) {
-                    printf("Physical address for virtual address '0vp%ds%d' of process ID %d: 0pf%ds%d\n", process->mpt->tables[i]->entries[j].page_num, offset, processId, process->mpt->tables[i]->entries[j].frame_num, offset);
-                }
+// Function to count the bytes of a process that virtual pages have been handed out for: the bytes of the
+// SecondaryPageTable regions it has touched, its shared segments aside
+static long long touchedBytes(const Process* process) {
+    const MemoryConfig* config = &process->vm->config;
+    long long bytes = process->touched_pages << config->page_shift;
+
+    // The last page only counts up to the end of the process
+    long long tailVpn = (process->memory_size - 1) >> config->page_shift;
+    PageTableEntry* tail = lookupPageTableEntry(process, tailVpn);
+    if (tail != NULL && (*tail & PTE_VALID)) bytes -= ((tailVpn + 1) << config->page_shift) - process->memory_size;
+    return bytes;
+}
+
+// Function to measure the physical memory of a process: its resident set size, and its proportional set size, which
+// charges each frame shared with other processes (after a fork, or in a shared segment) in equal parts to each page
+// mapping it. A huge page counts its HUGE_PAGE_FRAMES frames, a slab object the chunks it holds.
+static void processFootprint(const Process* process, const PhysicalMemory* pm, long long* rss, double* pss) {
+    const MemoryConfig* config = &pm->config;
+    *rss = 0;
+    *pss = 0;
+    long long base = 0;
+    SecondaryPageTable* spt;
+    while ((spt = nextPageTable(process->mpt, &base)) != NULL) {
+        if (process->huge_pages && lookupHugePageEntry(process, base) != NULL) {
+            *rss += (long long)HUGE_PAGE_FRAMES << config->page_shift;
+            *pss += (double)((long long)HUGE_PAGE_FRAMES << config->page_shift);
+            base += ENTRIES_PER_TABLE;
+            continue;
+        }
+        for (int j = 0; j < ENTRIES_PER_TABLE; j++) {
+            PageTableEntry entry = spt->entries[j];
+            if (!(entry & PTE_PRESENT)) continue;
+            if (entry & PTE_SLAB) {
+                long long bytes = (long long)__builtin_popcount(pteChunkMask(entry)) << config->chunk_shift;
+                *rss += bytes;
+                *pss += bytes;
+                continue;
             }
+            *rss += config->page_size;
+            *pss += (double)config->page_size / pm->ref_counts[pteFrame(entry)];
         }
-
-    } else {
-        // Print the physical address for the given virtual address
-        printf("Physical address for virtual address '%s' of process ID %d: 0pf%ds%d\n", virtualAddress, processId, frameNum, offset);
+        base += ENTRIES_PER_TABLE;
     }
 }
 
 // Function to display memory management statistics
 void displayStatistics(VirtualMemory* vm, PhysicalMemory* pm) {
     // Calculate hit rate as the ratio of successful accesses to total accesses
-    float hitRate = (num_accesses - page_faults) / (float)num_accesses * 100;
+    float hitRate = num_accesses ? (num_accesses - page_faults) / (float)num_accesses * 100 : 0;
 
-    // Calculate the total and remaining memory in both virtual and physical memory spaces
-    int totalVirtualMemory = NUM_PAGES * PAGE_SIZE;
-    int usedVirtualMemory = totalVirtualMemory - vm->remaining_memory;
+    // Calculate the TLB hit rate and the effective access time: a TLB hit costs one memory reference,
+    // a miss additionally costs one reference per page table level
+    const TLB* tlb = getTLB();
+    long long tlbLookups = tlb->hits + tlb->misses;
+    float tlbHitRatio = tlbLookups ? tlb->hits / (float)tlbLookups : 0;
+    float effectiveAccessTime = TLB_LOOKUP_TIME_NS + MEMORY_ACCESS_TIME_NS
+                              + (1 - tlbHitRatio) * PAGE_TABLE_LEVELS * MEMORY_ACCESS_TIME_NS;
 
-    int totalPhysicalMemory = NUM_FRAMES * FRAME_SIZE;
-    int usedPhysicalMemory = totalPhysicalMemory - pm->remaining_memory;
+    // Calculate the total and remaining memory in both virtual and physical memory spaces
+    long long totalVirtualMemory = vm->config.virtual_memory_size;
+    long long usedVirtualMemory = totalVirtualMemory - vm->remaining_memory;
+
+    long long totalPhysicalMemory = pm->config.physical_memory_size;
+    long long usedPhysicalMemory = totalPhysicalMemory - pm->remaining_memory;
+
+    // Page table metadata held in the processes' arenas
+    size_t arenaAllocated = 0, arenaReserved = 0;
+    long long touchedMemory = sharedSegmentBytes(); // Memory that virtual pages have been handed out for
+    Process* process;
+    for (int cursor = 0; (process = nextProcess(&cursor)) != NULL; ) {
+        arenaAllocated += process->mpt->arena.allocated;
+        arenaReserved += process->mpt->arena.reserved;
+        touchedMemory += touchedBytes(process);
+    }
 
     // Display the statistics
     printf("\nMemory Management Statistics:\n");
-    printf("Number of allocated pages in virtual memory: %llu\n", NUM_PAGES - (vm->remaining_memory / PAGE_SIZE));
-    printf("Number of frames in physical memory: %llu\n", NUM_FRAMES - (pm->remaining_memory / FRAME_SIZE));
+    printf("Number of allocated pages in virtual memory: %lld\n", vm->config.num_pages - (vm->remaining_memory >> vm->config.page_shift));
+    printf("Virtual pages handed out so far: %lld\n", vm->next_page);
+    printf("Page table memory: %zu bytes in use, %zu bytes reserved\n", arenaAllocated, arenaReserved);
+    printf("Number of frames in physical memory: %lld\n", pm->config.num_frames - countFreeFrames(pm));
     printf("Number of accesses in physical memory: %d\n", num_accesses);
     printf("Number of page faults: %d\n", page_faults);
+    printf("Number of page evictions (%s): %d\n", getReplacementPolicy() ? getReplacementPolicy()->name : "none", page_evictions);
     printf("Hit rate: %.2f%%\n", hitRate);
-    printf("Total memory used in virtual memory: %d bytes\n", usedVirtualMemory);
-    printf("Remaining memory in virtual memory: %d bytes\n", vm->remaining_memory);
-    printf("Total memory used in physical memory: %d bytes\n", usedPhysicalMemory);
-    printf("Remaining memory in physical memory: %d bytes\n", pm->remaining_memory);
+    printf("TLB hits: %lld, TLB misses: %lld\n", tlb->hits, tlb->misses);
+    printf("TLB hit rate: %.2f%%\n", tlbHitRatio * 100);
+    printf("Effective access time: %.2f ns\n", effectiveAccessTime);
+    printf("Total memory used in virtual memory: %lld bytes\n", usedVirtualMemory);
+    printf("Remaining memory in virtual memory: %lld bytes\n", vm->remaining_memory);
+    printf("Total memory used in physical memory: %lld bytes\n", usedPhysicalMemory);
+    printf("Remaining memory in physical memory: %lld bytes\n", pm->remaining_memory);
+    printFreeBlockStats(pm);
+
+    // Internal fragmentation: bytes backing processes (whole pages, or the chunks of their slab objects)
+    // beyond the bytes they reserved in the regions they have touched; utilization: chunks in use in the allocated frames
+    const SlabStats* slabs = getSlabStats();
+    long long privatePages = vm->next_page - vm->free_count - slabs->slab_pages;
+    long long backingMemory = (privatePages << vm->config.page_shift) + (slabs->object_chunks << vm->config.chunk_shift);
+    long long internalFragmentation = backingMemory - touchedMemory;
+    long long allocatedFrames = pm->config.num_frames - countFreeFrames(pm);
+    long long freeSlabChunks = slabs->slab_pages * vm->config.chunks_per_page - slabs->object_chunks;
+    long long slabObjects = 0;
+    for (int sizeClass = 1; sizeClass <= MAX_CHUNKS_PER_PAGE; sizeClass++) slabObjects += slabs->objects[sizeClass];
+    printf("Slab pages: %lld (objects in use: %lld, free chunks: %lld)\n", slabs->slab_pages, slabObjects, freeSlabChunks);
+    for (int sizeClass = 1; sizeClass <= MAX_CHUNKS_PER_PAGE; sizeClass++) {
+        if (slabs->slabs[sizeClass] == 0) continue;
+        printf("  %d-chunk objects: %lld in %lld slab pages\n", sizeClass, slabs->objects[sizeClass], slabs->slabs[sizeClass]);
+    }
+    printf("Internal fragmentation: %lld bytes (%.2f%% of the %lld bytes backing processes)\n", internalFragmentation,
+           backingMemory ? internalFragmentation * 100.0 / backingMemory : 0, backingMemory);
+    printf("Physical memory utilization: %.2f%% of allocated frame bytes are chunks in use\n",
+           allocatedFrames ? (countChunksInUse(pm) << pm->config.chunk_shift) * 100.0 / (allocatedFrames << pm->config.page_shift) : 0);
+
+    // Frames shared after a fork, and the copy-on-write faults that gave pages private copies
+    long long sharedFrames = 0, sharingPages = 0;
+    for (long long frameID = 0; frameID < pm->config.num_frames; frameID++) {
+        if (pm->ref_counts[frameID] > 1) {
+            sharedFrames++;
+            sharingPages += pm->ref_counts[frameID];
+        }
+    }
+    printf("Shared frames: %lld (mapped by %lld pages), private frames: %lld\n", sharedFrames, sharingPages, allocatedFrames - sharedFrames);
+    printf("Forks: %lld (pages shared at fork: %lld), copy-on-write faults: %lld (pages copied: %lld)\n",
+           forkStats.forks, forkStats.shared_pages, forkStats.cow_faults, forkStats.cow_copies);
+
+    // Pages mapped ahead of the faults of sequential and strided streams
+    printf("Readahead: %lld pages prefetched by %lld faults, %lld used (%.2f%%), %lld wasted; windows grew %lld times, shrank %lld times\n",
+           readaheadStats.prefetched, readaheadStats.readaheads, readaheadStats.hits,
+           readaheadStats.prefetched ? readaheadStats.hits * 100.0 / readaheadStats.prefetched : 0,
+           readaheadStats.wasted, readaheadStats.window_grows, readaheadStats.window_shrinks);
+
+    // Pages written to and read from the swap device
+    if (swapEnabled()) {
+        const SwapStats* swap = getSwapStats();
+        printf("Swap-ins: %lld (%lld bytes), swap-outs: %lld (%lld bytes in %lld batches, %lld writes)\n",
+               swap->swap_ins, swap->bytes_in, swap->swap_outs, swap->bytes_out, swap->writeback_batches, swap->writeback_calls);
+        printf("Evictions: %lld clean, %lld dirty, %lld dropped with swap full; pages cleaned ahead: %lld\n",
+               swap->clean_evictions, swap->dirty_evictions, swap->dropped, swap->cleaned_ahead);
+        printf("Swap slots in use: %lld of %lld, writeback stalls: %lld, read errors: %lld\n",
+               swap->slots_in_use, swap->slots, swap->stalls, swap->read_errors);
+    }
+
+    // Resident and proportional set size of each process
+    for (int cursor = 0; (process = nextProcess(&cursor)) != NULL; ) {
+        long long rss;
+        double pss;
+        processFootprint(process, pm, &rss, &pss);
+        printf("  Process %d: RSS %lld bytes, PSS %.0f bytes\n", process->id, rss, pss);
+    }
+
+    // Huge-page-backed processes are reported on their own, as their faults and walks cover whole regions
+    if (vm->config.huge_pages || hugePageStats.translations > 0) {
+        printf("Huge-page-backed processes (%lld KB huge pages):\n", ((long long)HUGE_PAGE_FRAMES << vm->config.page_shift) / KB);
+        printf("  Translations: %lld, page table walks: %lld (resolved by a huge page: %lld)\n",
+               hugePageStats.translations, hugePageStats.walks, hugePageStats.huge_walks);
+        printf("  Page faults: %lld (huge pages mapped: %lld, single-page fallbacks: %lld)\n",
+               hugePageStats.faults, hugePageStats.mappings, hugePageStats.fallbacks);
+        printf("  Huge pages split: %lld\n", hugePageStats.splits);
+    }
 }
 
-void requestAdditionalMemory(int processId, unsigned int additionalMemorySize, VirtualMemory* vm, PhysicalMemory* pm) {
+// Function to get the counters of huge-page-backed processes
+const HugePageStats* getHugePageStats(void) {
+    return &hugePageStats;
+}
+
+// Function to get the counters of copy-on-write forks
+const ForkStats* getForkStats(void) {
+    return &forkStats;
+}
+
+// Function to get the counters of readahead
+const ReadaheadStats* getReadaheadStats(void) {
+    return &readaheadStats;
+}
+
+// Function to replace the counters of huge pages, forks and readahead
+void restorePagingStats(const HugePageStats* huge, const ForkStats* fork, const ReadaheadStats* readahead) {
+    hugePageStats = *huge;
+    forkStats = *fork;
+    readaheadStats = *readahead;
+}
+
+// Function to find the frame a process's page is resident in, through its own entry or the huge page covering it,
+// or -1 if the page is not resident
+static int residentFrame(const Process* process, long long vpn, PageTableEntry entry) {
+    if (entry & PTE_PRESENT) return pteFrame(entry);
+    PageTableEntry* huge = lookupHugePageEntry(process, vpn);
+    return huge != NULL ? pteFrame(*huge) + PAGE_TABLE_INDEX(vpn, 0) : -1;
+}
+
+void requestAdditionalMemory(int processId, long long additionalMemorySize, VirtualMemory* vm, PhysicalMemory* pm) {
     Process* process = findProcessById(processId);
     if (process == NULL) {
         printf("Process with ID %d not found.\n", processId);
         return;
     }
 
-    if (additionalMemorySize > vm->remaining_memory || additionalMemorySize > pm->remaining_memory) {
-        printf("Insufficient virtual or physical memory available.\n");
+    // The new pages are faulted in on first access, so only virtual memory has to be available now
+    long long newSize = process->memory_size + additionalMemorySize;
+    if (additionalMemorySize <= 0 || additionalMemorySize > vm->remaining_memory
+        || (newSize + vm->config.page_mask) >> vm->config.page_shift > MAX_VPN) {
+        printf("Insufficient virtual memory available.\n");
         return;
     }
-
-    // get a free secondary page table that is not full
-    SecondaryPageTable* spt = NULL;
-    for (int i = 0; i < process->mpt->count; i++) {
-        if (process->mpt->tables[i]->size < SECONDARY_TABLE_SIZE) {
-            spt = process->mpt->tables[i];
-            break;
-        }
+    if ((newSize + vm->config.page_mask) >> vm->config.page_shift > segmentFloor(process)) {
+        printf("Process ID %d cannot grow into its shared segments.\n", processId);
+        return;
     }
 
-    // if no free secondary page table is found, allocate a new one
-    if (spt == NULL) {
-        int newTableSize = (additionalMemorySize < SECONDARY_TABLE_SIZE) ? additionalMemorySize : SECONDARY_TABLE_SIZE;
-        spt = allocateSecondaryPageTable(newTableSize);
-        if (spt == NULL) {
-            printf("Failed to allocate memory for the new secondary page table.\n");
+    // If the region of the current last page has been touched, extend its PageTableEntries up to the new end or the
+    // end of the region; the existing mappings are left as they are, and later regions are reserved on first touch
+    long long oldTailVpn = (process->memory_size - 1) >> vm->config.page_shift;
+    PageTableEntry* tail = lookupPageTableEntry(process, oldTailVpn);
+    if (tail != NULL && (*tail & PTE_VALID)) {
+        long long regionEnd = ((oldTailVpn | PAGE_TABLE_INDEX_MASK) + 1) << vm->config.page_shift;
+        if (reserveProcessPages(process, process->memory_size, newSize < regionEnd ? newSize : regionEnd, vm) == -1) {
+            printf("Failed to allocate enough virtual memory for the process.\n");
             return;
         }
-        process->mpt->tables[process->mpt->count++] = spt;
-    }
-
-    // allocate memory for the new pages
-    int remainingMemory = additionalMemorySize;
 
-    // loop should begin from the length of the entries array in the secondary page table
-    for (int i = spt->size / PAGE_SIZE; i < (spt->size + additionalMemorySize + PAGE_SIZE - 1) / PAGE_SIZE; i++) {
-        if (remainingMemory <= 0) break; // Stop if we've allocated enough memory
-        if (spt->entries[i].is_valid) continue; // Skip already allocated pages
-        int pageID = allocatePage(vm);
-        if (pageID == -1) {
-            printf("Failed to allocate enough virtual memory for the process.\n");
-            return;
+        // The old last page may now cover more chunks; a resident frame's copy of its chunk mask follows
+        int tailFrame = residentFrame(process, oldTailVpn, *tail);
+        if (tailFrame != -1 && !(*tail & PTE_SLAB)) {
+            pm->allocated_chunks[tailFrame] = pteChunkMask(*tail);
         }
+    }
 
-        // Initialize PageTableEntry for the current page
-        PageTableEntry* entry = &spt->entries[i];
-        entry->page_num = pageID; // Set the page number
-        entry->frame_num = -1; // Assuming no physical frame is allocated yet
-        entry->is_valid = true; // Mark as valid since we're allocating memory for it
+    // Update process memory size and deduct the added memory from the remaining virtual memory
+    process->memory_size = newSize;
+    vm->remaining_memory -= additionalMemorySize;
 
-        // Calculate how many chunks are needed for this secondary table
-        int chunksNeeded = spt->size / CHUNK_SIZE + (spt->size % CHUNK_SIZE != 0);
+    printf("Additional memory allocated to process ID %d. Total memory: %lld bytes.\n", processId, process->memory_size);
+}
 
-        // Allocate chunks within the allocated page
-        allocateChunksInPage(vm, pageID, chunksNeeded, entry);
-        chunksNeeded -= PAGE_SIZE / CHUNK_SIZE; // Update the number of chunks needed
+// Function to take the pages backing bytes [end, memory_size) away from a process, with their frames, and trim
+// the chunks of the new last page. A huge page lying wholly in the range is freed as one buddy block; one that
+// straddles the new end is split first. Returns the number of pages released.
+static long long releaseProcessPages(Process* process, long long end, VirtualMemory* vm, PhysicalMemory* pm) {
+    const MemoryConfig* config = &vm->config;
+    long long keepVpn = (end + config->page_mask) >> config->page_shift; // Pages below stay with the process
+    long long lastVpn = (process->memory_size + config->page_mask) >> config->page_shift;
+    long long pagesReleased = 0;
+
+    long long base = keepVpn & ~(long long)PAGE_TABLE_INDEX_MASK;
+    SecondaryPageTable* spt;
+    while (base < lastVpn && (spt = nextPageTable(process->mpt, &base)) != NULL && base < lastVpn) {
+        int first = base < keepVpn ? (int)(keepVpn - base) : 0;
+        int last = lastVpn - base < ENTRIES_PER_TABLE ? (int)(lastVpn - base) : ENTRIES_PER_TABLE;
+
+        PageTableEntry* huge = lookupHugePageEntry(process, base);
+        if (huge != NULL && first == 0) {
+            // The whole region goes: its frames go back to the buddy allocator as the block they were taken as
+            int firstFrame = pteFrame(*huge);
+            for (int i = 0; i < HUGE_PAGE_FRAMES; i++) replacementOnUnmap(firstFrame + i);
+            freeFrameBlock(pm, firstFrame, HUGE_PAGE_ORDER);
+            process->resident_pages -= HUGE_PAGE_FRAMES;
+            *huge = PTE_EMPTY;
+            tlbInvalidatePage(process->id, base);
+            TRACE_EVENT(EVENT_LEVEL_PAGING, EVENT_UNMAP, process->id, base, firstFrame);
+        } else if (huge != NULL) {
+            splitHugePage(process, base, pm);
+        }
 
-        // Update remainingMemory
-        remainingMemory -= PAGE_SIZE;
+        for (int i = first; i < last; i++) {
+            PageTableEntry* entry = &spt->entries[i];
+            if (!(*entry & PTE_VALID)) continue;
+            if (*entry & PTE_SLAB) {
+                slabFree(pteFrame(*entry), pteChunkMask(*entry), vm); // The slab page may still hold other objects
+                tlbInvalidatePage(process->id, base + i);
+            } else {
+                if (*entry & PTE_PRESENT) {
+                    TRACE_EVENT(EVENT_LEVEL_PAGING, EVENT_UNMAP, process->id, base + i, pteFrame(*entry));
+                    readaheadOnUnmap(process, entry);
+                    releaseFrame(process, base + i, pteFrame(*entry), pm);
+                    process->resident_pages--;
+                    tlbInvalidatePage(process->id, base + i);
+                }
+                freeVirtualPage(spt->page_nums[i], vm);
+            }
+            *entry = PTE_EMPTY;
+            spt->page_nums[i] = -1;
+            spt->valid_count--;
+            process->touched_pages--;
+            pagesReleased++;
+        }
+        base += ENTRIES_PER_TABLE;
     }
 
-    // Update process memory size
-    process->memory_size += additionalMemorySize;
-
-    // Update SecondaryPageTable size
-    spt->size += additionalMemorySize;
+    // The new last page keeps only the chunks the process still covers; a slab object keeps its size
+    long long tailVpn = keepVpn - 1;
+    int tailChunks = (end - (tailVpn << config->page_shift) + config->chunk_size - 1) >> config->chunk_shift;
+    PageTableEntry* tail = lookupPageTableEntry(process, tailVpn);
+    if (tail != NULL && (*tail & PTE_VALID) && !(*tail & PTE_SLAB) && tailChunks < config->chunks_per_page) {
+        SecondaryPageTable* tailTable = findLeafDirectory(process->mpt, tailVpn)->entries[PAGE_TABLE_INDEX(tailVpn, 1)];
+        unsigned int keep = (1u << tailChunks) - 1;
+        pteSetChunkMask(tail, pteChunkMask(*tail) & keep);
+        vm->allocated_chunks[tailTable->page_nums[PAGE_TABLE_INDEX(tailVpn, 0)]] &= keep;
+        int tailFrame = residentFrame(process, tailVpn, *tail);
+        if (tailFrame != -1) pm->allocated_chunks[tailFrame] &= keep;
+    }
+    return pagesReleased;
+}
 
-    // Deallocate process memory from physical memory
-    deallocatePagesFromPhysicalMemory(process, pm);
+void releaseMemory(int processId, long long releaseSize, VirtualMemory* vm, PhysicalMemory* pm) {
+    Process* process = findProcessById(processId);
+    if (process == NULL) {
+        printf("Process with ID %d not found.\n", processId);
+        return;
+    }
+    if (releaseSize <= 0 || releaseSize >= process->memory_size) {
+        printf("A process keeps at least one byte of memory; destroy the process to release all of it.\n");
+        return;
+    }
 
-    // Allocate memory in physical memory
-    allocatePagesToPhysicalMemory(process, pm);
+    long long newSize = process->memory_size - releaseSize;
+    long long pagesReleased = releaseProcessPages(process, newSize, vm, pm);
 
-    // Deduct the allocated memory from the remaining virtual and physical memory
-    vm->remaining_memory -= additionalMemorySize; 
-    pm->remaining_memory -= additionalMemorySize; 
+    // Update process memory size and give the released memory back to the remaining virtual memory
+    process->memory_size = newSize;
+    vm->remaining_memory += releaseSize;
 
-    printf("Additional memory allocated to process ID %d. Total memory: %u bytes.\n", processId, process->memory_size);
+    printf("Released %lld bytes (%lld pages) of process ID %d. Total memory: %lld bytes.\n",
+           releaseSize, pagesReleased, processId, process->memory_size);
 }
 
-void freeVirtualPage(int pageID, VirtualMemory* vm) {
-    if (vm == NULL || pageID < 0 || pageID >= NUM_PAGES) {
+void freeVirtualPage(long long pageID, VirtualMemory* vm) {
+    if (vm == NULL || pageID < 0 || pageID >= vm->next_page) {
         printf("Invalid virtual memory or page ID.\n");
         return;
     }
 
-    // Mark the page as free in the virtual memory structure
-    vm->pages[pageID].is_allocated = false;
+    uint64_t bit = 1ULL << (pageID % 64);
+    if (!(vm->allocated_pages[pageID / 64] & bit)) return; // Page is already free
+
+    // The page's contents are no longer needed in swap either
+    swapForgetPage(pageID);
+
+    // Mark the page and its chunks as free and push it back on the free-page stack
+    vm->allocated_chunks[pageID] = 0;
+    vm->allocated_pages[pageID / 64] &= ~bit;
+    vm->free_pages[vm->free_count++] = pageID;
 
-    // Update the remaining memory in the virtual memory structure
-    vm->remaining_memory += PAGE_SIZE;
+    // The remaining memory counts bytes reserved by processes, so it is given back by destroy_process
 }
 
 void freePhysicalFrame(int frameID, PhysicalMemory* pm) {
-    if (pm == NULL || frameID < 0 || frameID >= NUM_FRAMES) {
+    if (pm == NULL || frameID < 0 || frameID >= pm->config.num_frames) {
         printf("Invalid physical memory or frame ID.\n");
         return;
     }
 
-    // Mark the frame as free in the physical memory structure
-    pm->frames[frameID].is_allocated = false;
+    // Forget the frame's owner in the replacement policy
+    replacementOnUnmap(frameID);
 
-    // Update the remaining memory in the physical memory structure
-    pm->remaining_memory += FRAME_SIZE;
+    // A shared segment page is no longer resident once its frame is freed
+    segmentOnFrameFreed(frameID);
+
+    // Return the frame to the buddy allocator, which also updates the free-frame bitmap and the remaining memory
+    freeFrameBlock(pm, frameID, 0);
+}
+
+// Function to free the pages, frames and page table metadata of a process that is not registered (any more)
+static void freeProcess(Process* process, VirtualMemory* vm, PhysicalMemory* pm) {
+    long long base = 0;
+    SecondaryPageTable* spt;
+    while ((spt = nextPageTable(process->mpt, &base)) != NULL) {
+        splitHugePage(process, base, pm); // Free the frames of a huge page one by one below
+        for (int j = 0; j < ENTRIES_PER_TABLE; j++) {
+            PageTableEntry entry = spt->entries[j];
+            if (!(entry & PTE_VALID)) continue; // Not part of the process
+            if (entry & PTE_SLAB) {
+                slabFree(pteFrame(entry), pteChunkMask(entry), vm); // The slab page itself may still hold other objects
+                continue;
+            }
+            if (!(entry & PTE_SHARED)) {
+                freeVirtualPage(spt->page_nums[j], vm); // Free the virtual page; a shared segment's stay with the segment
+            }
+            if (entry & PTE_PRESENT) {
+                readaheadOnUnmap(process, &spt->entries[j]);
+                releaseFrame(process, base + j, pteFrame(entry), pm); // Free the frame, unless another process shares it
+            }
+        }
+        base += ENTRIES_PER_TABLE;
+    }
+    detachAllSegments(process, vm);
+    vm->remaining_memory += process->memory_size; // Give back the memory reserved by the process
+    arenaRelease(&process->mpt->arena); // Free the process, its master page table, directories and secondary page tables at once
 }
 
 // Function to destroy a process and free its resources
@@ -478,22 +1210,133 @@ void destroy_process(int processId, VirtualMemory* vm, PhysicalMemory* pm) {
         return;
     }
 
-    // Deallocate virtual memory
-    for (int i = 0; i < process->mpt->count; i++) {
-        SecondaryPageTable* spt = process->mpt->tables[i];
-        for (int j = 0; j < (spt->size + PAGE_SIZE - 1) / PAGE_SIZE; j++) {
-            PageTableEntry entry = spt->entries[j];
-            freeVirtualPage(entry.page_num, vm); // Free the virtual page
-            if (entry.frame_num != -1) {
-                freePhysicalFrame(entry.frame_num, pm); // Free the corresponding frame in physical memory
+    // Drop the process's cached translations before its frames can be reused
+    tlbInvalidateProcess(processId);
+
+    unregisterProcess(processId); // Before freeProcess releases the Process
+    freeProcess(process, vm, pm);
+
+    TRACE_EVENT(EVENT_LEVEL_LIFECYCLE, EVENT_DESTROY, processId, -1, -1);
+    printf("Process ID %d destroyed and resources freed.\n", processId);
+}
+
+// Function to free a process that never made it into the process table
+void discard_process(Process* process, VirtualMemory* vm, PhysicalMemory* pm) {
+    if (process == NULL) return;
+    freeProcess(process, vm, pm);
+}
+
+// Function to copy one SecondaryPageTable of a parent into its child, sharing the parent's resident frames
+static int forkPageTable(Process* parent, Process* child, long long base, SecondaryPageTable* spt,
+                         VirtualMemory* vm, PhysicalMemory* pm) {
+    splitHugePage(parent, base, pm); // Frames are shared page by page
+    SecondaryPageTable* copy = findOrCreatePageTable(child->mpt, base);
+    if (copy == NULL) return -1;
+
+    // The child's pages are new virtual pages with the parent's chunks, reserved in one pass
+    long long pageIDs[ENTRIES_PER_TABLE];
+    int pages = 0;
+    for (int i = 0; i < ENTRIES_PER_TABLE; i++) {
+        pages += (spt->entries[i] & (PTE_VALID | PTE_SLAB | PTE_SHARED)) == PTE_VALID;
+    }
+    if (allocatePages(vm, pages, pageIDs) == -1) return -1;
+
+    int nextPage = 0;
+    for (int i = 0; i < ENTRIES_PER_TABLE; i++) {
+        PageTableEntry* entry = &spt->entries[i];
+        if (!(*entry & PTE_VALID)) continue;
+
+        if (*entry & PTE_SLAB) {
+            // A slab object is at most half a page: the child gets an object of its own instead of sharing it
+            long long pageID;
+            int frameID;
+            unsigned int chunkMask;
+            if (slabAllocate(__builtin_popcount(pteChunkMask(*entry)), vm, &pageID, &frameID, &chunkMask) == -1) {
+                while (nextPage < pages) freeVirtualPage(pageIDs[nextPage++], vm);
+                return -1;
             }
-            free(spt->entries); // Free the dynamic memory for page table entries
+            copy->entries[i] = PTE_EMPTY | PTE_VALID | PTE_SLAB | (*entry & PTE_PROT_MASK);
+            pteSetFrame(&copy->entries[i], frameID);
+            pteSetChunkMask(&copy->entries[i], chunkMask);
+            copy->page_nums[i] = pageID;
+            copy->valid_count++;
+            child->touched_pages++;
+            continue;
+        }
+
+        if (*entry & PTE_SHARED) {
+            copy->page_nums[i] = spt->page_nums[i]; // The child is attached to the same segment page
+        } else {
+            copy->page_nums[i] = pageIDs[nextPage++];
+            vm->allocated_chunks[copy->page_nums[i]] = vm->allocated_chunks[spt->page_nums[i]];
+            child->touched_pages++;
+        }
+        copy->entries[i] = *entry & ~(PTE_REFERENCED | PTE_PREFETCHED);
+        copy->valid_count++;
+        if (*entry & PTE_SWAPPED) {
+            swapSetPageSlot(copy->page_nums[i], swapSlotOf(spt->page_nums[i])); // The child reads the same slot back
+        }
+        if (!(*entry & PTE_PRESENT)) continue;
+
+        // Share the resident frame; a writable page is copied by whichever process writes to it first
+        int frameID = pteFrame(*entry);
+        if (replacementOnShare(frameID, child, base + i) == -1) {
+            pteSetFrame(&copy->entries[i], -1);
+            continue; // The child faults the page in on its own instead
+        }
+        pm->ref_counts[frameID]++;
+        child->resident_pages++;
+        forkStats.shared_pages++;
+        if ((*entry & PTE_PROT_WRITE) && !(*entry & PTE_SHARED)) { // Writes to a shared segment are seen by all
+            *entry |= PTE_COW;
+            copy->entries[i] |= PTE_COW;
+        }
+    }
+    return 0;
+}
+
+// Function to fork a process: the child gets a copy of the parent's page tables sharing its frames copy-on-write
+Process* fork_process(int parentId, int childId, VirtualMemory* vm, PhysicalMemory* pm) {
+    Process* parent = findProcessById(parentId);
+    if (parent == NULL) {
+        printf("Process with ID %d not found.\n", parentId);
+        return NULL;
+    }
+    if (findProcessById(childId) != NULL) {
+        printf("Process ID %d already exists. Please enter a different ID.\n", childId);
+        return NULL;
+    }
+
+    Process* child = create_process(childId, parent->memory_size, vm);
+    if (child == NULL) return NULL;
+    child->huge_pages = parent->huge_pages;
+
+    // Register the child before it shares anything, so a failure below can tear it down like any other process
+    if (registerProcess(child).slot == -1) {
+        printf("Failed to register process %d.\n", childId);
+        freeProcess(child, vm, pm);
+        return NULL;
+    }
+    if (forkSegmentAttachments(parent, child) == -1) {
+        printf("Failed to attach the child process to its parent's shared segments.\n");
+        unregisterProcess(childId);
+        freeProcess(child, vm, pm);
+        return NULL;
+    }
+
+    // Only the regions the parent has touched have tables to copy; the rest stay untouched in the child too
+    long long base = 0;
+    SecondaryPageTable* spt;
+    for (; (spt = nextPageTable(parent->mpt, &base)) != NULL; base += ENTRIES_PER_TABLE) {
+        if (spt->valid_count == 0) continue;
+        if (forkPageTable(parent, child, base, spt, vm, pm) == -1) {
+            printf("Failed to allocate enough virtual memory for the child process.\n");
+            unregisterProcess(childId);
+            freeProcess(child, vm, pm);
+            return NULL;
         }
-        free(process->mpt->tables[i]); // Free the secondary page table itself
     }
-    free(process->mpt->tables); // Free the array of secondary page tables
-    free(process->mpt); // Free the master page table structure
-    free(process); // Free the process structure itself
 
-    printf("Process ID %d destroyed and resources freed.\n", processId);
-}
\ No newline at end of file
+    forkStats.forks++;
+    return child;
+}
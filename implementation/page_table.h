@@ -1,50 +1,363 @@
 #include <stdbool.h> // For bool type
 #include <stdlib.h> // For dynamic allocation
+#include <stdint.h> // For the packed PageTableEntry
 #include "memory_config.h" // For memory configuration
 #include "physical_memory.h"
+#include "arena.h" // For the per-process page table arena
 
 
 #ifndef PAGE_TABLE_H
 #define PAGE_TABLE_H
 
-#define SECONDARY_TABLE_SIZE (4 * MB)
+// Per-process virtual page numbers (VPNs) index a radix tree of PAGE_TABLE_LEVELS levels. Each level consumes
+// PAGE_TABLE_INDEX_BITS of the VPN, from the MasterPageTable's root PageDirectory down to the SecondaryPageTable
+// leaves, whose entries are the PageTableEntries. Level 0 is the leaf's entry index; level PAGE_TABLE_LEVELS - 1
+// selects the root directory's entry. A page table walk costs one memory reference per level.
+#define PAGE_TABLE_LEVELS 4
+#define PAGE_TABLE_INDEX_BITS 9
+#define ENTRIES_PER_TABLE (1 << PAGE_TABLE_INDEX_BITS)
+#define PAGE_TABLE_INDEX_MASK (ENTRIES_PER_TABLE - 1)
+#define PAGE_TABLE_INDEX(vpn, level) ((int)(((vpn) >> ((level) * PAGE_TABLE_INDEX_BITS)) & PAGE_TABLE_INDEX_MASK))
 
+// Per-process VPNs range over [0, MAX_VPN); a SecondaryPageTable maps ENTRIES_PER_TABLE pages (2MB of 4KB pages)
+#define MAX_VPN (1LL << VPN_BITS)
 
-typedef struct PageTableEntry {
-    int page_num;               // ID of the page in the virtual memory
-    int frame_num;              // ID in a Frame in the physical memory
-    bool is_valid;              // Indicates if the entry is valid
-    int chunks[PAGE_SIZE / KB]; // List of chunk IDs used to store the process
-} PageTableEntry;
+// Error results of accessMemory and translateVirtualToPhysicalAddress
+#define ACCESS_NO_FRAME (-1)        // The page fault could not be resolved: no frame available
+#define ACCESS_INVALID_PAGE (-2)    // The page is not part of the process
+#define ACCESS_INVALID_ADDRESS (-3) // The virtual address is malformed, or its offset is past the page or slab object
+#define ACCESS_NO_PROCESS (-4)      // The process does not exist
+#define ACCESS_PROTECTION (-5)      // The page does not allow the access (e.g. a write to a read-only page)
 
+_Static_assert(PAGE_TABLE_LEVELS * PAGE_TABLE_INDEX_BITS == VPN_BITS, "the page table levels must cover every VPN bit");
+
+// A huge page maps the ENTRIES_PER_TABLE pages of one SecondaryPageTable to as many contiguous frames
+#define HUGE_PAGE_FRAMES ENTRIES_PER_TABLE
+
+_Static_assert(HUGE_PAGE_ORDER == PAGE_TABLE_INDEX_BITS, "a huge page must span exactly one SecondaryPageTable");
+
+
+/**
+ * A PageTableEntry is packed into 64 bits:
+ *
+ *   bits  0-31  frame number (PTE_NO_FRAME, i.e. -1, whenever the page is not present)
+ *   bit     32  valid       the page belongs to the process
+ *   bit     33  present     the page is mapped to the frame in bits 0-31
+ *   bit     34  referenced  set when the page is accessed, cleared by the Clock replacement policy
+ *   bit     35  dirty       set when the page is written
+ *   bits 36-38  protection  read, write and execute permission
+ *   bits 39-46  chunk mask  bit i is set when chunk i of the page is in use
+ *   bit     47  huge        the entry is a PageDirectory's huge-page entry, mapping HUGE_PAGE_FRAMES frames from bits 0-31
+ *   bit     48  slab        the page is an object of a shared slab page (see slab.h): the chunk mask holds the object's
+ *                           chunks within that page, and the frame is shared and stays resident
+ *   bit     49  cow         copy-on-write: the frame may be shared with a forked process, so the first write to the
+ *                           page copies it to a private frame (see fork_process)
+ *   bit     50  shared      the page belongs to a shared segment (see shared_segment.h): the virtual page is the
+ *                           segment's, and the frame is shared by every process that has faulted the page in
+ *   bit     51  swapped     the page is not present and its contents are in a swap slot (see swap.h), read back
+ *                           when the page is faulted in
+ *   bit     52  prefetched  the page was mapped by readahead and has not been accessed since (see Readahead)
+ *
+ * Use the PTE_* flags and the pte* accessors below rather than shifting by hand.
+**/
+typedef uint64_t PageTableEntry;
+
+#define PTE_FRAME_MASK 0xFFFFFFFFULL
+#define PTE_NO_FRAME PTE_FRAME_MASK
+#define PTE_VALID (1ULL << 32)
+#define PTE_PRESENT (1ULL << 33)
+#define PTE_REFERENCED (1ULL << 34)
+#define PTE_DIRTY (1ULL << 35)
+#define PTE_PROT_READ (1ULL << 36)
+#define PTE_PROT_WRITE (1ULL << 37)
+#define PTE_PROT_EXEC (1ULL << 38)
+#define PTE_PROT_MASK (PTE_PROT_READ | PTE_PROT_WRITE | PTE_PROT_EXEC)
+#define PTE_CHUNK_SHIFT 39
+#define PTE_CHUNK_MASK (0xFFULL << PTE_CHUNK_SHIFT)
+#define PTE_HUGE (1ULL << 47)
+#define PTE_SLAB (1ULL << 48)
+#define PTE_COW (1ULL << 49)
+#define PTE_SHARED (1ULL << 50)
+#define PTE_SWAPPED (1ULL << 51)
+#define PTE_PREFETCHED (1ULL << 52)
+
+// An entry with no frame, no flags and no chunks in use
+#define PTE_EMPTY PTE_NO_FRAME
+
+_Static_assert(MAX_CHUNKS_PER_PAGE <= 8, "the chunk mask of a PageTableEntry holds 8 chunks");
+
+// Returns the frame the entry maps, or -1 if the page is not present.
+// The frame field holds PTE_NO_FRAME whenever the present bit is clear, so this needs no branch.
+static inline int pteFrame(PageTableEntry pte) {
+    return (int)(uint32_t)(pte & PTE_FRAME_MASK);
+}
+
+// Maps the entry to frame, or marks it not present if frame is -1
+static inline void pteSetFrame(PageTableEntry* pte, int frame) {
+    if (frame < 0) {
+        *pte = (*pte & ~(PTE_FRAME_MASK | PTE_PRESENT)) | PTE_NO_FRAME;
+    } else {
+        *pte = (*pte & ~PTE_FRAME_MASK) | (uint32_t)frame | PTE_PRESENT;
+    }
+}
+
+// Returns the chunk mask of the entry
+static inline unsigned int pteChunkMask(PageTableEntry pte) {
+    return (unsigned int)((pte & PTE_CHUNK_MASK) >> PTE_CHUNK_SHIFT);
+}
+
+// Replaces the chunk mask of the entry
+static inline void pteSetChunkMask(PageTableEntry* pte, unsigned int mask) {
+    *pte = (*pte & ~PTE_CHUNK_MASK) | ((uint64_t)(mask & 0xFF) << PTE_CHUNK_SHIFT);
+}
+
+// Define the SecondaryPageTable structure, a leaf of the page table tree mapping ENTRIES_PER_TABLE pages
 typedef struct SecondaryPageTable {
-    PageTableEntry* entries;    // Dynamic array of PageTableEntry
-    int size;                   // Size of this secondary page table, in bytes
+    PageTableEntry entries[ENTRIES_PER_TABLE];  // The leaf's PageTableEntries, PTE_EMPTY where the page is not part of the process
+    long long page_nums[ENTRIES_PER_TABLE];     // ID of the page in virtual memory backing each entry, kept apart to keep entries dense
+    int valid_count;                            // Number of entries with the valid bit set
 } SecondaryPageTable;
 
+// Define the PageDirectory structure, an interior node of the page table tree.
+// A level 1 directory can map the region of a SecondaryPageTable with a single huge-page entry instead: the
+// SecondaryPageTable then still records which pages belong to the process, but its entries are not present.
+typedef struct PageDirectory {
+    void* entries[ENTRIES_PER_TABLE];   // Next-level PageDirectory, or SecondaryPageTable at level 1; NULL if nothing below is mapped
+    PageTableEntry* huge_entries;       // Level 1 only: huge-page entry of each slot, allocated on the first huge mapping
+} PageDirectory;
+
+// Define the MasterPageTable structure, the root of a process's page table tree.
+// Directories and tables are only allocated below the VPN ranges the process uses. The Process, its
+// MasterPageTable and every node of the tree live in the process's arena, so destroying it is a single release.
 typedef struct MasterPageTable {
-    SecondaryPageTable** tables; // Array of pointers to SecondaryPageTable
-    int count;                   // Number of SecondaryPageTable pointers
+    PageDirectory* root;        // Level PAGE_TABLE_LEVELS - 1 directory
+    long long directories;      // Number of PageDirectories in the tree, including the root
+    long long count;            // Number of SecondaryPageTables in the tree
+    Arena arena;                // Memory of the process's page table metadata
 } MasterPageTable;
 
+/**
+ * Readahead: a process whose page faults form a stream, READAHEAD_MIN_STREAK faults in a row the same number of pages
+ * apart (at most READAHEAD_MAX_STRIDE, either way), has the next `window` pages of the stream mapped along with the
+ * faulting page, marked PTE_PREFETCHED. The window starts at READAHEAD_MIN_WINDOW pages. When the stream faults again
+ * right after the pages prefetched for it, they were all used, and the window doubles up to READAHEAD_MAX_WINDOW;
+ * whenever a prefetched page is unmapped before it is accessed, the window halves.
+**/
+#define READAHEAD_MIN_STREAK 3
+#define READAHEAD_MAX_STRIDE 16
+#define READAHEAD_MIN_WINDOW 4
+#define READAHEAD_MAX_WINDOW 64
+
+// Define the Readahead structure, the fault stream of a process (Process.readahead)
+typedef struct Readahead {
+    long long last_fault;       // Page of the process's last fault, -1 before the first
+    long long stride;           // Pages between its last two faults
+    long long next_fault;       // Page the stream faults on once it has used the pages prefetched for it, -1 if none
+    int streak;                 // Faults in a row the same stride apart
+    int window;                 // Pages to prefetch at the next readahead
+} Readahead;
+
 typedef struct Process {
     int id;
-    int memory_size;       // Total memory size of the process
-    MasterPageTable* mpt;  // Pointer to the MasterPageTable
+    long long memory_size;      // Total memory size of the process, in bytes
+    long long resident_pages;   // Number of pages currently mapped to frames
+    long long touched_pages;    // Pages (and slab objects) reserved in the regions touched so far, shared segments aside
+    bool huge_pages;            // Page faults map whole SecondaryPageTable regions with huge pages where possible
+    MasterPageTable* mpt;       // Pointer to the MasterPageTable
+    VirtualMemory* vm;          // Virtual memory the process's pages are reserved from, a table region at a time on first touch
+    struct SegmentAttachment* attachments; // Shared segments mapped past the end of the process (see shared_segment.h)
+    Readahead readahead;        // Fault stream, for prefetching
 } Process;
 
-Process* create_process(int id, int memory_size, VirtualMemory* vm);
-Process* findProcessById(int pid);
+// Define the HugePageStats structure, the counters of huge-page-backed processes (Process.huge_pages)
+typedef struct HugePageStats {
+    long long translations;     // Accesses and address translations
+    long long walks;            // Translations that missed the TLB and walked the page table
+    long long huge_walks;       // Walks resolved by a huge-page entry
+    long long faults;           // Page faults
+    long long mappings;         // Faults resolved by mapping a huge page
+    long long fallbacks;        // Faults in a region eligible for a huge page that fell back to a single page (no contiguous frames)
+    long long splits;           // Huge pages split into single pages (eviction or unmapping of part of the region)
+} HugePageStats;
+
+// Define the ReadaheadStats structure, the counters of readahead (Readahead)
+typedef struct ReadaheadStats {
+    long long readaheads;       // Faults that prefetched pages
+    long long prefetched;       // Pages mapped by readahead
+    long long hits;             // Prefetched pages accessed
+    long long wasted;           // Prefetched pages unmapped before they were accessed
+    long long window_grows;     // Times a stream's window doubled
+    long long window_shrinks;   // Times a stream's window halved
+} ReadaheadStats;
+
+// Define the ForkStats structure, the counters of copy-on-write forks (fork_process)
+typedef struct ForkStats {
+    long long forks;            // Processes forked
+    long long shared_pages;     // Pages whose resident frame a child shared with its parent at fork time
+    long long cow_faults;       // Writes to copy-on-write pages
+    long long cow_copies;       // Copy-on-write faults that copied the page to a new frame; the others found it no longer shared
+} ForkStats;
+
+Process* create_process(int id, long long memory_size, VirtualMemory* vm);
+long long allocatePage(VirtualMemory* vm);
+long long allocatePages(VirtualMemory* vm, long long count, long long* pageIDs);
 void printProcess(const Process* process);
+PageTableEntry* lookupPageTableEntry(const Process* process, long long vpn);
+
+/**
+ * lookupPageId function returns the ID of the page in virtual memory backing a per-process virtual page number,
+ * or -1 if no table maps the VPN.
+
+   Parameters:
+   - process: The process that owns the page.
+   - vpn: The per-process virtual page number.
+**/
+long long lookupPageId(const Process* process, long long vpn);
+
+/**
+ * findOrCreatePageTable function returns the SecondaryPageTable mapping vpn, allocating it and any missing
+ * PageDirectories from the process's arena. Returns NULL if the arena cannot grow.
+
+   Parameters:
+   - mpt: The MasterPageTable of the process.
+   - vpn: The per-process virtual page number.
+**/
+SecondaryPageTable* findOrCreatePageTable(MasterPageTable* mpt, long long vpn);
+
+/**
+ * releaseFrame function drops the reference page vpn of a process holds on frameID. The frame is freed once no page
+ * maps it any more; until then the pages of other processes sharing it (after a fork, or in a shared segment) keep it.
+ * The caller updates the PageTableEntry and the process's resident page count.
+
+   Parameters:
+   - process: The process whose page maps the frame.
+   - vpn: The per-process virtual page number mapped to the frame.
+   - frameID: The frame to release.
+   - pm: A pointer to the PhysicalMemory structure.
+**/
+void releaseFrame(Process* process, long long vpn, int frameID, PhysicalMemory* pm);
+
+/**
+ * nextPageTable function finds the first SecondaryPageTable of a MasterPageTable that maps a VPN at or after *vpn,
+ * skipping the subtrees that are not allocated. On success *vpn is set to the first VPN the table maps.
+ * Iterate over every table with: for (long long base = 0; (spt = nextPageTable(mpt, &base)); base += ENTRIES_PER_TABLE)
+
+   Parameters:
+   - mpt: The MasterPageTable to search.
+   - vpn: The VPN to start from; updated to the base VPN of the table found.
+**/
+SecondaryPageTable* nextPageTable(const MasterPageTable* mpt, long long* vpn);
+
+/**
+ * lookupHugePageEntry function returns the huge-page entry mapping the region of vpn, or NULL if the region is not
+ * mapped by a huge page. The frame of vpn is then pteFrame(*entry) + PAGE_TABLE_INDEX(vpn, 0).
+
+   Parameters:
+   - process: The process whose page table is searched.
+   - vpn: Any per-process virtual page number within the region.
+**/
+PageTableEntry* lookupHugePageEntry(const Process* process, long long vpn);
+
+/**
+ * splitHugePage function replaces the huge page mapping the region of vpn, if any, by single-page mappings of the
+ * same frames, so part of the region can be evicted or unmapped. Frames of pages that no longer belong to the
+ * process are freed. The referenced and dirty bits are kept per page in the SecondaryPageTable throughout.
+
+   Parameters:
+   - process: The process owning the region.
+   - vpn: Any per-process virtual page number within the region.
+   - pm: A pointer to the PhysicalMemory structure.
+**/
+void splitHugePage(Process* process, long long vpn, PhysicalMemory* pm);
+
+/**
+ * getHugePageStats function returns the counters of huge-page-backed processes.
+**/
+const HugePageStats* getHugePageStats(void);
+
 int findFreeFrame(PhysicalMemory* pm);
 void allocatePagesToPhysicalMemory(Process* process, PhysicalMemory* pm);
 void deallocatePagesFromPhysicalMemory(Process* process, PhysicalMemory* pm);
-int accessMemory(Process* process, int page_id);
-void translateVirtualToPhysicalAddress(PhysicalMemory* pm, char* virtualAddress, int processId);
+int handlePageFault(Process* process, long long vpn, PhysicalMemory* pm);
+int accessMemory(Process* process, long long vpn, bool isWrite, PhysicalMemory* pm);
+int translateVirtualToPhysicalAddress(PhysicalMemory* pm, const char* virtualAddress, int processId, char* physicalAddress);
 void displayStatistics(VirtualMemory* vm, PhysicalMemory* pm);
-void requestAdditionalMemory(int processId, unsigned int additionalMemorySize, VirtualMemory* vm, PhysicalMemory* pm);
-void freeVirtualPage(int pageID, VirtualMemory* vm);
+void requestAdditionalMemory(int processId, long long additionalMemorySize, VirtualMemory* vm, PhysicalMemory* pm);
+
+/**
+ * releaseMemory function shrinks a process by releaseSize bytes, the counterpart of requestAdditionalMemory.
+ * The pages past the new end leave the process with their frames and their cached translations, a table at a time;
+ * the pages before it, and their mappings, are untouched. The process must keep at least one byte.
+
+   Parameters:
+   - processId: The ID of the process to shrink.
+   - releaseSize: The number of bytes to release from the end of the process.
+   - vm: A pointer to the VirtualMemory structure.
+   - pm: A pointer to the PhysicalMemory structure.
+**/
+void releaseMemory(int processId, long long releaseSize, VirtualMemory* vm, PhysicalMemory* pm);
+void freeVirtualPage(long long pageID, VirtualMemory* vm);
 void freePhysicalFrame(int frameID, PhysicalMemory* pm);
 void destroy_process(int processId, VirtualMemory* vm, PhysicalMemory* pm);
 
+/**
+ * discard_process function frees a process that create_process returned but that is not registered in the process
+ * table, e.g. because registerProcess ran out of memory: its pages, frames and page tables, and the virtual memory it
+ * reserved, as destroy_process does for a registered process.
+
+   Parameters:
+   - process: The process to free.
+   - vm: A pointer to the VirtualMemory structure.
+   - pm: A pointer to the PhysicalMemory structure.
+**/
+void discard_process(Process* process, VirtualMemory* vm, PhysicalMemory* pm);
+
+/**
+ * fork_process function creates a child process with a copy of the parent's page tables. The child gets virtual
+ * pages of its own with the parent's chunks, and maps the parent's resident frames, whose reference counts go up,
+ * instead of copying them: writable pages are marked copy-on-write in both processes, so the first write to such a
+ * page copies it to a private frame. Slab objects are copied to a new object. Huge pages of the parent are split,
+ * as frames are shared page by page. The cost follows the size of the parent's page tables, not of its memory.
+ * The child is registered in the process table before any frame is shared with it. Returns the child, or NULL
+ * (with nothing shared) if the parent does not exist, the child ID is taken, or virtual memory or the process table
+ * runs out.
+
+   Parameters:
+   - parentId: The ID of the process to fork.
+   - childId: The ID of the new process.
+   - vm: A pointer to the VirtualMemory structure.
+   - pm: A pointer to the PhysicalMemory structure.
+**/
+Process* fork_process(int parentId, int childId, VirtualMemory* vm, PhysicalMemory* pm);
+
+/**
+ * getForkStats function returns the counters of copy-on-write forks.
+**/
+const ForkStats* getForkStats(void);
+
+/**
+ * readaheadOnUnmap function forgets that a page being unmapped was prefetched, counting it as wasted and halving
+ * the process's readahead window if the page was never accessed.
+
+   Parameters:
+   - process: The process that owns the page.
+   - entry: The page's PageTableEntry.
+**/
+void readaheadOnUnmap(Process* process, PageTableEntry* entry);
+
+/**
+ * getReadaheadStats function returns the counters of readahead.
+**/
+const ReadaheadStats* getReadaheadStats(void);
+
+/**
+ * restorePagingStats function replaces the huge page, fork and readahead counters, as when a saved state is loaded.
+
+   Parameters:
+   - huge: The huge page counters.
+   - fork: The copy-on-write fork counters.
+   - readahead: The readahead counters.
+**/
+void restorePagingStats(const HugePageStats* huge, const ForkStats* fork, const ReadaheadStats* readahead);
+
 #endif // PAGE_TABLE_H
\ No newline at end of file
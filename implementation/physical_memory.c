@@ -1,47 +1,171 @@
 #include <stdlib.h> // For dynamic memory allocation
+#include <string.h> // For memset
 #include "physical_memory.h"
 
 
+static void freeListPush(PhysicalMemory* pm, int frameID, int order);
+
 // Function to initialize virtual memory
-VirtualMemory* initializeVirtualMemory() {
+VirtualMemory* initializeVirtualMemory(const MemoryConfig* config) {
+    MemoryConfig geometry = *config;
+    if (initializeMemoryConfig(&geometry) != 0) return NULL;
+
     VirtualMemory* vm = malloc(sizeof(VirtualMemory)); // Allocate memory for the virtual memory structure
     if (vm == NULL) {
         // Handle memory allocation failure
         return NULL;
     }
+    vm->config = geometry;
 
-    for (unsigned long long i = 0; i < NUM_PAGES; i++) {
-        vm->pages[i].id = i; // Set page ID
+    // Every page starts out free and untouched; page IDs are handed out from next_page upwards
+    vm->allocated_pages = NULL;
+    vm->allocated_chunks = NULL;
+    vm->free_pages = NULL;
+    vm->free_count = 0;
+    vm->next_page = 0;
+    vm->capacity = 0;
+    vm->mapped = false;
+    long long initialCapacity = geometry.num_pages < VIRTUAL_MEMORY_INITIAL_CAPACITY ? geometry.num_pages : VIRTUAL_MEMORY_INITIAL_CAPACITY;
+    if (growVirtualMemory(vm, initialCapacity) != 0) {
+        freeMemory(vm, NULL);
+        return NULL;
     }
 
-    // remaining_memory = VIRTUAL_MEMORY_SIZE; // Initialize remaining memory in virtual memory
-    vm->remaining_memory = VIRTUAL_MEMORY_SIZE;
+    // remaining_memory = virtual_memory_size; // Initialize remaining memory in virtual memory
+    vm->remaining_memory = geometry.virtual_memory_size;
     return vm;
 }
 
 // Function to initialize physical memory
-PhysicalMemory* initializePhysicalMemory() {
+PhysicalMemory* initializePhysicalMemory(const MemoryConfig* config) {
+    MemoryConfig geometry = *config;
+    if (initializeMemoryConfig(&geometry) != 0) return NULL;
+
     PhysicalMemory* pm = malloc(sizeof(PhysicalMemory)); // Allocate memory for the physical memory structure
     if (pm == NULL) {
         // Handle memory allocation failure
         return NULL;
     }
+    pm->config = geometry;
+    pm->mapped = false;
 
-    for (unsigned long long i = 0; i < NUM_FRAMES; i++) {
-        pm->frames[i].id = i; // Set frame ID
+    // Size the bitmaps from the number of frames; calloc leaves every frame allocated and every chunk unused
+    long long numFrames = geometry.num_frames;
+    pm->bitmap_words = (numFrames + 63) / 64;
+    pm->summary_words = (pm->bitmap_words + 63) / 64;
+    pm->free_frames = calloc(pm->bitmap_words, sizeof(uint64_t));
+    pm->free_summary = calloc(pm->summary_words, sizeof(uint64_t));
+    pm->allocated_chunks = calloc(numFrames, sizeof(uint8_t));
+    pm->ref_counts = calloc(numFrames, sizeof(uint32_t));
+    pm->block_next = malloc(numFrames * sizeof(int));
+    pm->block_prev = malloc(numFrames * sizeof(int));
+    pm->block_order = malloc(numFrames * sizeof(int8_t));
+    if (!pm->free_frames || !pm->free_summary || !pm->allocated_chunks || !pm->ref_counts
+        || !pm->block_next || !pm->block_prev || !pm->block_order) {
+        freeMemory(NULL, pm);
+        return NULL;
     }
 
-    // remaining_memory = PHYSICAL_MEMORY_SIZE; // Initialize remaining memory in physical memory
-    pm->remaining_memory = PHYSICAL_MEMORY_SIZE;
+    // Every frame starts out free; bits past the last frame in the last word stay clear
+    for (long long w = 0; w < pm->bitmap_words; w++) {
+        long long framesInWord = numFrames - w * 64;
+        pm->free_frames[w] = framesInWord >= 64 ? ~0ULL : (1ULL << framesInWord) - 1;
+        pm->free_summary[w / 64] |= 1ULL << (w % 64);
+    }
+
+    // Cover the frames with the largest aligned buddy blocks that fit, lowest frames first
+    pm->max_order = 0;
+    while (pm->max_order < BUDDY_MAX_ORDER && (2LL << pm->max_order) <= numFrames) pm->max_order++;
+    memset(pm->block_order, -1, numFrames * sizeof(int8_t));
+    for (int order = 0; order <= BUDDY_MAX_ORDER; order++) {
+        pm->free_lists[order] = -1;
+        pm->free_blocks[order] = 0;
+    }
+    for (long long frameID = 0; frameID < numFrames; ) {
+        int order = frameID ? __builtin_ctzll(frameID) : pm->max_order;
+        if (order > pm->max_order) order = pm->max_order;
+        while (frameID + (1LL << order) > numFrames) order--;
+        freeListPush(pm, frameID, order);
+        frameID += 1LL << order;
+    }
+
+    // remaining_memory = physical_memory_size; // Initialize remaining memory in physical memory
+    pm->remaining_memory = geometry.physical_memory_size;
     return pm;
 }
 
+// Function to copy virtual memory metadata arrays mapped from a state image to the heap, so they can be reallocated
+static int moveVirtualMemoryToHeap(VirtualMemory* vm) {
+    size_t pageBytes = PAGE_BITMAP_WORDS(vm->capacity) * sizeof(uint64_t);
+    uint64_t* allocatedPages = malloc(pageBytes);
+    uint8_t* allocatedChunks = malloc(vm->capacity * sizeof(uint8_t));
+    long long* freePages = malloc(vm->capacity * sizeof(long long));
+    if (!allocatedPages || !allocatedChunks || !freePages) {
+        free(allocatedPages);
+        free(allocatedChunks);
+        free(freePages);
+        return -1;
+    }
+    memcpy(allocatedPages, vm->allocated_pages, pageBytes);
+    memcpy(allocatedChunks, vm->allocated_chunks, vm->capacity * sizeof(uint8_t));
+    memcpy(freePages, vm->free_pages, vm->free_count * sizeof(long long));
+    vm->allocated_pages = allocatedPages;
+    vm->allocated_chunks = allocatedChunks;
+    vm->free_pages = freePages;
+    vm->mapped = false;
+    return 0;
+}
+
+// Function to grow the virtual memory metadata arrays to cover at least `pages` pages
+int growVirtualMemory(VirtualMemory* vm, long long pages) {
+    if (pages <= vm->capacity) return 0;
+    if (pages > vm->config.num_pages) return -1;
+
+    long long capacity = vm->capacity ? vm->capacity : VIRTUAL_MEMORY_INITIAL_CAPACITY;
+    while (capacity < pages) capacity *= 2;
+    if (capacity > vm->config.num_pages) capacity = vm->config.num_pages;
+
+    if (vm->mapped && moveVirtualMemoryToHeap(vm) != 0) return -1;
+
+    // Grow each array in place; on failure the arrays already grown are simply larger than needed
+    uint64_t* allocatedPages = realloc(vm->allocated_pages, PAGE_BITMAP_WORDS(capacity) * sizeof(uint64_t));
+    if (allocatedPages == NULL) return -1;
+    vm->allocated_pages = allocatedPages;
+    uint8_t* allocatedChunks = realloc(vm->allocated_chunks, capacity * sizeof(uint8_t));
+    if (allocatedChunks == NULL) return -1;
+    vm->allocated_chunks = allocatedChunks;
+    long long* freePages = realloc(vm->free_pages, capacity * sizeof(long long));
+    if (freePages == NULL) return -1;
+    vm->free_pages = freePages;
+
+    // Clear the entries that are new
+    long long oldPageWords = PAGE_BITMAP_WORDS(vm->capacity);
+    memset(vm->allocated_pages + oldPageWords, 0, (PAGE_BITMAP_WORDS(capacity) - oldPageWords) * sizeof(uint64_t));
+    memset(vm->allocated_chunks + vm->capacity, 0, (capacity - vm->capacity) * sizeof(uint8_t));
+    vm->capacity = capacity;
+    return 0;
+}
+
 // Function to free the allocated memory for virtual and physical memory
 void freeMemory(VirtualMemory* vm, PhysicalMemory* pm) {
     if (vm != NULL) {
+        if (!vm->mapped) {
+            free(vm->allocated_pages);
+            free(vm->allocated_chunks);
+            free(vm->free_pages);
+        }
         free(vm); // Free virtual memory
     }
     if (pm != NULL) {
+        if (!pm->mapped) {
+            free(pm->free_frames);
+            free(pm->free_summary);
+            free(pm->allocated_chunks);
+            free(pm->ref_counts);
+            free(pm->block_next);
+            free(pm->block_prev);
+            free(pm->block_order);
+        }
         free(pm); // Free physical memory
     }
 }
@@ -54,13 +178,18 @@ void printVirtualMemory(const VirtualMemory* vm) {
     }
 
     printf("Virtual Memory Contents:\n");
-    for (unsigned long long i = 0; i < NUM_PAGES; i++) {
-        printf("Page %llu (Allocated: %s): ", i, vm->pages[i].is_allocated ? "Yes" : "No");
-        for (int j = 0; j < PAGE_SIZE / KB; j++) {
-            printf("Chunk %d (Offset: %d, Allocated: %s), ", j, vm->pages[i].chunks[j].offset, vm->pages[i].chunks[j].is_allocated ? "Yes" : "No");
+    for (long long i = 0; i < vm->next_page; i++) {
+        int allocated = (vm->allocated_pages[i / 64] >> (i % 64)) & 1;
+        unsigned int chunks = vm->allocated_chunks[i];
+        printf("Page %lld (Allocated: %s): ", i, allocated ? "Yes" : "No");
+        for (int j = 0; j < vm->config.chunks_per_page; j++) {
+            printf("Chunk %d (Offset: %d, Allocated: %s), ", j, j * vm->config.chunk_size, (chunks >> j) & 1 ? "Yes" : "No");
         }
         printf("\n");
     }
+    if (vm->next_page < vm->config.num_pages) {
+        printf("Pages %lld-%lld (Allocated: No): never allocated\n", vm->next_page, vm->config.num_pages - 1);
+    }
 }
 
 // Function to print the values in physical memory
@@ -71,10 +200,12 @@ void printPhysicalMemory(const PhysicalMemory* pm) {
     }
 
     printf("Physical Memory Contents:\n");
-    for (unsigned long long i = 0; i < NUM_FRAMES; i++) {
-        printf("Frame %llu (Allocated: %s): ", i, pm->frames[i].is_allocated ? "Yes" : "No");
-        for (int j = 0; j < FRAME_SIZE / KB; j++) {
-            printf("Chunk %d (Offset: %d, Allocated: %s), ", j, pm->frames[i].chunks[j].offset, pm->frames[i].chunks[j].is_allocated ? "Yes" : "No");
+    for (long long i = 0; i < pm->config.num_frames; i++) {
+        int allocated = !((pm->free_frames[i / 64] >> (i % 64)) & 1);
+        unsigned int chunks = pm->allocated_chunks[i];
+        printf("Frame %lld (Allocated: %s): ", i, allocated ? "Yes" : "No");
+        for (int j = 0; j < pm->config.chunks_per_page; j++) {
+            printf("Chunk %d (Offset: %d, Allocated: %s), ", j, j * pm->config.chunk_size, (chunks >> j) & 1 ? "Yes" : "No");
         }
         printf("\n");
     }
@@ -83,13 +214,15 @@ void printPhysicalMemory(const PhysicalMemory* pm) {
 // Function to print allocated pages and their chunks in virtual memory
 void printAllocatedVirtualMemory(const VirtualMemory* vm) {
     int allocatedPagesFound = 0;
-    for (unsigned long long i = 0; i < NUM_PAGES; i++) {
-        if (vm->pages[i].is_allocated) {
-            printf("\nAllocated Virtual Page: %d\n", vm->pages[i].id);
+    for (long long w = 0; w < PAGE_BITMAP_WORDS(vm->next_page); w++) {
+        for (uint64_t word = vm->allocated_pages[w]; word != 0; word &= word - 1) {
+            long long pageID = w * 64 + __builtin_ctzll(word);
+            printf("\nAllocated Virtual Page: %lld\n", pageID);
             // Print details about allocated chunks within this page
-            for (int j = 0; j < PAGE_SIZE / KB; j++) {
-                if (vm->pages[i].chunks[j].is_allocated) {
-                    printf("\tAllocated Chunk: %d (Offset: %d)\n", j, vm->pages[i].chunks[j].offset);
+            unsigned int chunks = vm->allocated_chunks[pageID];
+            for (int j = 0; j < vm->config.chunks_per_page; j++) {
+                if ((chunks >> j) & 1) {
+                    printf("\tAllocated Chunk: %d (Offset: %d)\n", j, j * vm->config.chunk_size);
                 }
             }
             allocatedPagesFound++;
@@ -103,13 +236,19 @@ void printAllocatedVirtualMemory(const VirtualMemory* vm) {
 // Function to print allocated frames and their chunks in physical memory
 void printAllocatedFrameMemory(const PhysicalMemory* pm) {
     int allocatedFramesFound = 0;
-    for (unsigned long long i = 0; i < NUM_FRAMES; i++) {
-        if (pm->frames[i].is_allocated) {
-            printf("\nAllocated Physical Frame: %d\n", pm->frames[i].id);
+    for (int w = 0; w < pm->bitmap_words; w++) {
+        uint64_t allocated = ~pm->free_frames[w];
+        if (w == pm->bitmap_words - 1 && pm->config.num_frames % 64 != 0) {
+            allocated &= (1ULL << (pm->config.num_frames % 64)) - 1; // Bits past the last frame are not frames
+        }
+        for (; allocated != 0; allocated &= allocated - 1) {
+            int frameID = w * 64 + __builtin_ctzll(allocated);
+            printf("\nAllocated Physical Frame: %d\n", frameID);
             // Print details about allocated chunks within this frame
-            for (int j = 0; j < FRAME_SIZE / KB; j++) {
-                if (pm->frames[i].chunks[j].is_allocated) {
-                    printf("\tAllocated Chunk: %d (Offset: %d)\n", j, pm->frames[i].chunks[j].offset);
+            unsigned int chunks = pm->allocated_chunks[frameID];
+            for (int j = 0; j < pm->config.chunks_per_page; j++) {
+                if ((chunks >> j) & 1) {
+                    printf("\tAllocated Chunk: %d (Offset: %d)\n", j, j * pm->config.chunk_size);
                 }
             }
             allocatedFramesFound++;
@@ -118,4 +257,206 @@ void printAllocatedFrameMemory(const PhysicalMemory* pm) {
     if (allocatedFramesFound == 0) {
         printf("\nNo allocated frames in physical memory.\n");
     }
-}
\ No newline at end of file
+}
+
+// Function to mark a frame as allocated in the free-frame bitmap
+static void markFrameAllocated(PhysicalMemory* pm, int frameID) {
+    int word = frameID / 64;
+    uint64_t bit = 1ULL << (frameID % 64);
+    if (!(pm->free_frames[word] & bit)) return; // Already allocated
+
+    pm->free_frames[word] &= ~bit;
+    if (pm->free_frames[word] == 0) {
+        pm->free_summary[word / 64] &= ~(1ULL << (word % 64)); // No free frames left in this word
+    }
+    pm->ref_counts[frameID] = 1;
+    pm->remaining_memory -= pm->config.page_size;
+}
+
+// Function to mark a frame as free in the free-frame bitmap
+static void markFrameFree(PhysicalMemory* pm, int frameID) {
+    int word = frameID / 64;
+    uint64_t bit = 1ULL << (frameID % 64);
+    if (pm->free_frames[word] & bit) return; // Already free
+
+    pm->free_frames[word] |= bit;
+    pm->free_summary[word / 64] |= 1ULL << (word % 64);
+    pm->allocated_chunks[frameID] = 0;
+    pm->ref_counts[frameID] = 0;
+    pm->remaining_memory += pm->config.page_size;
+}
+
+// Function to put a free block on the free list of its order
+static void freeListPush(PhysicalMemory* pm, int frameID, int order) {
+    int head = pm->free_lists[order];
+    pm->block_prev[frameID] = -1;
+    pm->block_next[frameID] = head;
+    if (head != -1) pm->block_prev[head] = frameID;
+    pm->free_lists[order] = frameID;
+    pm->block_order[frameID] = order;
+    pm->free_blocks[order]++;
+}
+
+// Function to take a free block off the free list of its order
+static void freeListRemove(PhysicalMemory* pm, int frameID) {
+    int order = pm->block_order[frameID];
+    int prev = pm->block_prev[frameID];
+    int next = pm->block_next[frameID];
+    if (prev != -1) {
+        pm->block_next[prev] = next;
+    } else {
+        pm->free_lists[order] = next;
+    }
+    if (next != -1) pm->block_prev[next] = prev;
+    pm->block_order[frameID] = -1;
+    pm->free_blocks[order]--;
+}
+
+// Function to allocate an aligned block of 2^order frames with the buddy allocator
+int allocateFrameBlock(PhysicalMemory* pm, int order) {
+    if (order < 0 || order > pm->max_order) return -1;
+
+    // The smallest free block that is large enough
+    int blockOrder = order;
+    while (blockOrder <= pm->max_order && pm->free_lists[blockOrder] == -1) blockOrder++;
+    if (blockOrder > pm->max_order) return -1; // No free block is large enough
+
+    int frameID = pm->free_lists[blockOrder];
+    freeListRemove(pm, frameID);
+
+    // Split it, keeping the lower half and returning the upper half of each split
+    while (blockOrder > order) {
+        blockOrder--;
+        freeListPush(pm, frameID + (1 << blockOrder), blockOrder);
+    }
+
+    for (int i = 0; i < 1 << order; i++) {
+        markFrameAllocated(pm, frameID + i);
+    }
+    return frameID;
+}
+
+// Function to release a block of 2^order frames and merge it with its free buddies
+void freeFrameBlock(PhysicalMemory* pm, int firstFrame, int order) {
+    if (order < 0 || order > pm->max_order || firstFrame < 0 || (firstFrame & ((1 << order) - 1)) != 0
+        || firstFrame + (1LL << order) > pm->config.num_frames) {
+        return;
+    }
+
+    // A block with frames that are already free is released frame by frame, skipping those
+    for (int i = 0; order > 0 && i < 1 << order; i++) {
+        int frameID = firstFrame + i;
+        if ((pm->free_frames[frameID / 64] >> (frameID % 64)) & 1) {
+            for (int j = 0; j < 1 << order; j++) freeFrameBlock(pm, firstFrame + j, 0);
+            return;
+        }
+    }
+    if (order == 0 && ((pm->free_frames[firstFrame / 64] >> (firstFrame % 64)) & 1)) return; // Already free
+
+    for (int i = 0; i < 1 << order; i++) {
+        markFrameFree(pm, firstFrame + i);
+    }
+
+    // Merge with the buddy (the other half of the next larger block) while it is free and whole
+    int frameID = firstFrame;
+    while (order < pm->max_order) {
+        int buddy = frameID ^ (1 << order);
+        if (buddy >= pm->config.num_frames || pm->block_order[buddy] != order) break;
+        freeListRemove(pm, buddy);
+        if (buddy < frameID) frameID = buddy;
+        order++;
+    }
+    freeListPush(pm, frameID, order);
+}
+
+// Function to compute the fraction of free frames too fragmented for an allocation of 2^order frames
+double externalFragmentation(const PhysicalMemory* pm, int order) {
+    long long freeFrames = 0;
+    long long usableFrames = 0;
+    for (int k = 0; k <= pm->max_order; k++) {
+        long long frames = pm->free_blocks[k] << k;
+        freeFrames += frames;
+        if (k >= order) usableFrames += frames;
+    }
+    return freeFrames ? 1.0 - (double)usableFrames / freeFrames : 0;
+}
+
+// Function to print the free block counts and fragmentation of each order
+void printFreeBlockStats(const PhysicalMemory* pm) {
+    printf("Free frame blocks by order (order: blocks, external fragmentation):\n");
+    for (int order = 0; order <= pm->max_order; order++) {
+        printf("  %2d (%lld KB): %lld, %.2f%%\n", order, ((long long)pm->config.page_size << order) / KB,
+               pm->free_blocks[order], externalFragmentation(pm, order) * 100);
+    }
+}
+
+// Function to find the lowest free frame using the two-level bitmap
+int findFirstFreeFrame(const PhysicalMemory* pm) {
+    for (int s = 0; s < pm->summary_words; s++) {
+        if (pm->free_summary[s]) {
+            int word = s * 64 + __builtin_ctzll(pm->free_summary[s]);
+            return word * 64 + __builtin_ctzll(pm->free_frames[word]);
+        }
+    }
+    return -1; // Physical memory is full
+}
+
+// Function to find the lowest run of `count` contiguous free frames
+int findFreeFrameRun(const PhysicalMemory* pm, int count) {
+    if (count <= 0 || count > pm->config.num_frames) return -1;
+    if (count == 1) return findFirstFreeFrame(pm);
+
+    int runStart = 0;
+    int runLength = 0;
+    for (int w = 0; w < pm->bitmap_words; w++) {
+        uint64_t word = pm->free_frames[w];
+        int base = w * 64;
+
+        if (word == ~0ULL) { // 64 free frames: extend the current run
+            if (runLength == 0) runStart = base;
+            runLength += 64;
+            if (runLength >= count) return runStart;
+            continue;
+        }
+        if (word == 0) { // 64 allocated frames: break the current run
+            runLength = 0;
+            continue;
+        }
+
+        // Mixed word: alternate between runs of free (set) and allocated (clear) bits
+        int bit = 0;
+        while (bit < 64) {
+            uint64_t rest = word >> bit;
+            if (rest & 1) {
+                int ones = __builtin_ctzll(~rest); // Shifted-in zeros bound this to 64 - bit
+                if (runLength == 0) runStart = base + bit;
+                runLength += ones;
+                if (runLength >= count) return runStart;
+                bit += ones;
+            } else {
+                runLength = 0;
+                if (rest == 0) break; // No free frames left in this word
+                bit += __builtin_ctzll(rest);
+            }
+        }
+    }
+    return -1; // No run of the requested length
+}
+
+// Function to count the free frames in physical memory
+int countFreeFrames(const PhysicalMemory* pm) {
+    long long freeFrames = 0;
+    for (int order = 0; order <= pm->max_order; order++) {
+        freeFrames += pm->free_blocks[order] << order;
+    }
+    return (int)freeFrames;
+}
+
+// Function to count the chunks in use in physical memory
+long long countChunksInUse(const PhysicalMemory* pm) {
+    long long chunks = 0;
+    for (long long i = 0; i < pm->config.num_frames; i++) {
+        chunks += __builtin_popcount(pm->allocated_chunks[i]);
+    }
+    return chunks;
+}
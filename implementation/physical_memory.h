@@ -1,52 +1,88 @@
 #include <stdio.h>  // For printf
+#include <stdint.h> // For uint64_t bitmap words
 #include "memory_config.h"
 #include "virtual_memory.h"
 
 #ifndef PHYSICAL_MEMORY_H
 #define PHYSICAL_MEMORY_H
 
-// Define the Frame structure
-typedef struct Frame {
-    int id; // Frame identifier
-    Chunk chunks[FRAME_SIZE / KB]; // Array of chunks within the frame
-    int is_allocated; // 1 if all chunks in the frame are allocated, 0 otherwise
-} Frame;
+// Largest order of a buddy block: 2^30 frames, as frame numbers are 31 bits
+#define BUDDY_MAX_ORDER 30
 
 /**
- * Define the PhysicalMemory structure
- * This function initializes physical memory by allocating memory for a structure called PhysicalMemory using malloc.
- * It iterates through each frame in the physical memory, setting its ID. 
- * The remaining memory in the physical memory structure is initialized, and a pointer to the allocated memory is returned.
- * It returns a pointer to the allocated PhysicalMemory structure if successful, 
- * otherwise NULL in case of memory allocation failure.
+ * Define the PhysicalMemory structure.
+ * Frame metadata is kept as dense arrays rather than an array of per-frame structures: a frame's ID is its index,
+ * a frame is allocated while its free_frames bit is clear, and its chunks in use are a byte (bit j for chunk j).
+ * The arrays are sized from the configured number of frames: one bit per frame, and one summary bit per bitmap word.
+ *
+ * Frames are handed out by a binary buddy allocator: the free frames form blocks of 2^order frames aligned to their
+ * size, kept on one free list per order. The lists are threaded through arrays indexed by a block's first frame,
+ * so splitting a block on allocation and merging it with its buddy on release take O(log n) list operations.
 **/
 typedef struct PhysicalMemory {
-    Frame frames[NUM_FRAMES]; // Array of frames in physical memory
-    int remaining_memory;     // Remaining memory in physical memory
+    MemoryConfig config;            // Geometry of the memory system
+    uint64_t* free_frames;          // Bit i is set while frame i is free
+    uint64_t* free_summary;         // Bit w is set while free_frames[w] has a free frame
+    uint8_t* allocated_chunks;      // Chunk mask of each frame
+    uint32_t* ref_counts;           // Number of pages mapping each frame: 1 when allocated, more while shared by forked processes
+    int bitmap_words;               // Number of words in free_frames
+    int summary_words;              // Number of words in free_summary
+    long long remaining_memory;     // Remaining memory in physical memory
+
+    // Buddy allocator
+    int* block_next;                            // Next free block of the same order, by first frame; -1 ends the list
+    int* block_prev;                            // Previous free block of the same order; -1 at the head of the list
+    int8_t* block_order;                        // Order of the free block starting at each frame, -1 if none starts there
+    int free_lists[BUDDY_MAX_ORDER + 1];        // First free block of each order, -1 if there is none
+    long long free_blocks[BUDDY_MAX_ORDER + 1]; // Number of free blocks of each order
+    int max_order;                              // Largest order a block can have in this physical memory
+    bool mapped;                                // The arrays live in a loaded state image (see snapshot.h) and are not freed
 } PhysicalMemory;
 
 // Function prototypes
 
 /**
  * initializeVirtualMemory function initializes virtual memory by allocating memory for a structure called VirtualMemory using malloc.
- * It iterates through each page in the virtual memory, setting its ID. 
- * The remaining memory in the virtual memorystructure is initialized, and a pointer to the allocated memory is returned.
- * It returns a pointer to the allocated VirtualMemory structure if successful, otherwise NULL in case of memory allocation failure.
+ * It keeps a copy of the memory configuration, whose derived fields it recomputes, and sizes the page bitmaps, chunk bitmaps and free-page stack for VIRTUAL_MEMORY_INITIAL_CAPACITY pages and clears them,
+ * so its cost does not depend on the size of the virtual address space.
+ * The remaining memory in the virtual memory structure is initialized, and a pointer to the allocated memory is returned.
+ * It returns a pointer to the allocated VirtualMemory structure if successful, otherwise NULL in case of an invalid
+ * configuration or memory allocation failure.
+
+   Parameters:
+   - config: The geometry of the memory system.
 **/
-VirtualMemory* initializeVirtualMemory(void); // Initialize virtual memory
+VirtualMemory* initializeVirtualMemory(const MemoryConfig* config); // Initialize virtual memory
 
 /**
  * initializePhysicalMemory a function initializes physical memory by allocating memory for a structure called PhysicalMemory using malloc.
- * It iterates through each frame in the physical memory, setting its ID. The remaining memory in the physical memory
+ * It keeps a copy of the memory configuration, sizes the frame bitmaps from its number of frames, marks every frame free in the free-frame bitmap and clears the chunk bitmap.
+ * The frames are then split into the largest aligned buddy blocks that fit and put on the free lists. The remaining memory in the physical memory
  * structure is initialized, and a pointer to the allocated memory is returned.
- * It returns a pointer to the allocated PhysicalMemory structure if successful, otherwise NULL in case of memory allocation failure.
+ * It returns a pointer to the allocated PhysicalMemory structure if successful, otherwise NULL in case of an invalid
+ * configuration or memory allocation failure.
+
+   Parameters:
+   - config: The geometry of the memory system.
 **/
-PhysicalMemory* initializePhysicalMemory(void); // Initialize physical memory
+PhysicalMemory* initializePhysicalMemory(const MemoryConfig* config); // Initialize physical memory
+
+/**
+ * growVirtualMemory function makes sure the virtual memory metadata arrays cover at least `pages` pages,
+ * doubling their capacity as often as needed. New pages start out free with no chunks in use.
+ * Arrays mapped from a state image are copied to the heap the first time they grow.
+ * It returns 0 on success, or -1 if pages exceeds the configured number of pages or the arrays cannot be grown.
+
+   Parameters:
+   - vm: A pointer to the VirtualMemory structure.
+   - pages: The number of pages the arrays must cover.
+**/
+int growVirtualMemory(VirtualMemory* vm, long long pages);
 
 /**
  * freeMemory function frees the allocated memory for both virtual and physical memory. 
  * It checks if the pointers to virtual and physical memory are not NULL, 
- * and if so, it frees the memory using the free function.
+ * and if so, it frees the memory (including the metadata arrays, unless they are mapped from a state image) using the free function.
  
    Parameters:
   - vm: A pointer to the VirtualMemory structure.
@@ -58,8 +94,9 @@ void freeMemory(VirtualMemory* vm, PhysicalMemory* pm);
  * printVirtualMemory function prints the values stored in virtual memory and returns none. 
  * It checks if the virtual memory is initialized (vm != NULL), and if not, 
  * it prints a message indicating that virtual memory is not initialized.
- * For each page in the virtual memory, it prints whether the page is allocated or not, 
+ * For each page handed out so far, it prints whether the page is allocated or not (from the page bitmap), 
  * along with information about each chunk within the page, including its offset and whether it's allocated.
+ * The pages that have never been handed out are summarized in a single line.
    
    Parameters:
    - vm: A pointer to the VirtualMemory structure.
@@ -81,7 +118,7 @@ void printPhysicalMemory(const PhysicalMemory* pm);
 
 /**
  * printAllocatedVirtualMemory function prints the allocated pages and their chunks in virtual memory. 
- * It iterates through each page in the virtual memory, checks if the page is allocated, and if so, 
+ * It scans the page bitmap a word (64 pages) at a time, skipping words with no allocated page, and for each allocated page 
  * prints information about the allocated page and its chunks. For each allocated chunk within the allocated page, 
  * it prints the chunk ID and offset. If no allocated pages are found, it prints a message indicating so.
 
@@ -92,7 +129,7 @@ void printAllocatedVirtualMemory(const VirtualMemory* vm);
 
 /**
  * printAllocatedFrameMemory function prints the allocated frames and their chunks in physical memory. 
- * It iterates through each frame in the physical memory, checks if the frame is allocated, and if so, 
+ * It scans the free-frame bitmap a word (64 frames) at a time, skipping words with no allocated frame, and for each allocated frame 
  * prints information about the allocated frame and its chunks. For each allocated chunk within the allocated frame, 
  * it prints the chunk ID and offset.If no allocated frames are found, it prints a message indicating so.
 
@@ -101,4 +138,87 @@ void printAllocatedVirtualMemory(const VirtualMemory* vm);
 **/
 void printAllocatedFrameMemory(const PhysicalMemory* pm);
 
+/**
+ * allocateFrameBlock function allocates 2^order contiguous frames whose first frame is a multiple of 2^order.
+ * It takes the smallest free block of at least that order and splits it, putting the unused halves back on the
+ * lower-order free lists, then marks the frames allocated in the free-frame bitmap and deducts them from the
+ * remaining memory. A single frame is an order 0 block.
+ * It returns the first frame of the block, or -1 if no free block is large enough.
+
+   Parameters:
+   - pm: A pointer to the PhysicalMemory structure.
+   - order: log2 of the number of frames to allocate, between 0 and pm->max_order.
+**/
+int allocateFrameBlock(PhysicalMemory* pm, int order);
+
+/**
+ * freeFrameBlock function releases 2^order frames starting at firstFrame and merges the block with its buddy
+ * for as long as the buddy is a free block of the same order. The frames' chunk masks are cleared and their
+ * memory added back to the remaining memory. Any part of a block can be released on its own, e.g. single frames
+ * of a block allocated with a higher order. Releasing a frame that is already free has no effect.
+
+   Parameters:
+   - pm: A pointer to the PhysicalMemory structure.
+   - firstFrame: The first frame of the block, a multiple of 2^order.
+   - order: log2 of the number of frames to release.
+**/
+void freeFrameBlock(PhysicalMemory* pm, int firstFrame, int order);
+
+/**
+ * externalFragmentation function returns the fraction of free frames that cannot serve an allocation of 2^order
+ * frames because they lie in smaller free blocks: 0 if every free frame is in a block of at least that order
+ * (or no frame is free), 1 if none is.
+
+   Parameters:
+   - pm: A pointer to the PhysicalMemory structure.
+   - order: The allocation order to measure fragmentation for.
+**/
+double externalFragmentation(const PhysicalMemory* pm, int order);
+
+/**
+ * printFreeBlockStats function prints, for every order up to pm->max_order, the number of free buddy blocks
+ * and the external fragmentation for allocations of that order.
+
+   Parameters:
+   - pm: A pointer to the PhysicalMemory structure.
+**/
+void printFreeBlockStats(const PhysicalMemory* pm);
+
+/**
+ * findFirstFreeFrame function returns the lowest free frame ID, or -1 if physical memory is full.
+ * It finds the first non-zero summary word, then the first free frame inside the bitmap word it points to,
+ * using count-trailing-zeros on each level, so a lookup touches at most summary_words + 1 words.
+
+   Parameters:
+   - pm: A pointer to the PhysicalMemory structure.
+**/
+int findFirstFreeFrame(const PhysicalMemory* pm);
+
+/**
+ * findFreeFrameRun function returns the first frame ID of the lowest run of `count` contiguous free frames,
+ * or -1 if there is no such run. Fully free and fully allocated bitmap words are consumed 64 frames at a time;
+ * mixed words are walked run by run with count-trailing-zeros.
+
+   Parameters:
+   - pm: A pointer to the PhysicalMemory structure.
+   - count: The number of contiguous free frames required.
+**/
+int findFreeFrameRun(const PhysicalMemory* pm, int count);
+
+/**
+ * countFreeFrames function returns the number of free frames, summed over the buddy free block counts.
+
+   Parameters:
+   - pm: A pointer to the PhysicalMemory structure.
+**/
+int countFreeFrames(const PhysicalMemory* pm);
+
+/**
+ * countChunksInUse function returns the number of chunks in use over all frames, computed with a popcount over the chunk masks.
+
+   Parameters:
+   - pm: A pointer to the PhysicalMemory structure.
+**/
+long long countChunksInUse(const PhysicalMemory* pm);
+
 #endif // PHYSICAL_MEMORY_H
\ No newline at end of file
@@ -0,0 +1,183 @@
+#include <stdlib.h> // For dynamic memory allocation
+#include <string.h> // For memcpy
+#include "process_table.h"
+
+
+// The process table, allocated on the first registration
+static ProcessTable table = {.free_slot = -1, .bucket_mask = -1};
+
+
+// Function to get the first bucket of a pid's probe run
+static int bucketOf(int pid) {
+    return (int)(((unsigned int)pid * 2654435761u) & (unsigned int)table.bucket_mask);
+}
+
+// Function to find the bucket holding a pid, or -1 if the pid is not registered
+static int findBucket(int pid) {
+    if (table.buckets == NULL) return -1;
+    for (int bucket = bucketOf(pid); table.buckets[bucket] != 0; bucket = (bucket + 1) & table.bucket_mask) {
+        if (table.slots[table.buckets[bucket] - 1].process->id == pid) {
+            return bucket;
+        }
+    }
+    return -1;
+}
+
+// Function to put a slot in the first empty bucket of its pid's probe run
+static void insertBucket(int slot) {
+    int bucket = bucketOf(table.slots[slot].process->id);
+    while (table.buckets[bucket] != 0) bucket = (bucket + 1) & table.bucket_mask;
+    table.buckets[bucket] = slot + 1;
+}
+
+// Function to double the hash index, rehashing every registered process
+static int growBuckets(void) {
+    int buckets = table.buckets ? 2 * (table.bucket_mask + 1) : PROCESS_TABLE_INITIAL_CAPACITY;
+    int* newBuckets = calloc(buckets, sizeof(int));
+    if (newBuckets == NULL) return -1;
+
+    free(table.buckets);
+    table.buckets = newBuckets;
+    table.bucket_mask = buckets - 1;
+    for (int slot = 0; slot < table.slot_count; slot++) {
+        if (table.slots[slot].process != NULL) insertBucket(slot);
+    }
+    return 0;
+}
+
+// Function to take a free slot, reusing freed slots before adding new ones
+static int takeSlot(void) {
+    if (table.free_slot != -1) {
+        int slot = table.free_slot;
+        table.free_slot = table.slots[slot].next_free;
+        return slot;
+    }
+    if (table.slot_count == table.slot_capacity) {
+        int capacity = table.slot_capacity ? 2 * table.slot_capacity : PROCESS_TABLE_INITIAL_CAPACITY;
+        ProcessSlot* slots = realloc(table.slots, capacity * sizeof(ProcessSlot));
+        if (slots == NULL) return -1;
+        table.slots = slots;
+        table.slot_capacity = capacity;
+    }
+    table.slots[table.slot_count].generation = 0;
+    return table.slot_count++;
+}
+
+// Function to add a process to the table
+ProcessHandle registerProcess(Process* process) {
+    if (process == NULL || findBucket(process->id) != -1) return PROCESS_HANDLE_NONE;
+
+    // Keep the hash index at most half full, so probe runs stay short
+    if (2 * (table.count + 1) > table.bucket_mask + 1 && growBuckets() != 0) return PROCESS_HANDLE_NONE;
+    int slot = takeSlot();
+    if (slot == -1) return PROCESS_HANDLE_NONE;
+
+    table.slots[slot].process = process;
+    table.slots[slot].next_free = -1;
+    insertBucket(slot);
+    table.count++;
+    return (ProcessHandle){slot, table.slots[slot].generation};
+}
+
+// Function to remove a process from the table
+Process* unregisterProcess(int pid) {
+    int bucket = findBucket(pid);
+    if (bucket == -1) return NULL;
+
+    int slot = table.buckets[bucket] - 1;
+    Process* process = table.slots[slot].process;
+
+    // Empty the bucket, then move back every later entry of the probe run that may no longer be reachable:
+    // an entry can fill the hole unless its home bucket lies cyclically in (hole, its bucket]
+    int hole = bucket;
+    for (int next = (hole + 1) & table.bucket_mask; table.buckets[next] != 0; next = (next + 1) & table.bucket_mask) {
+        int home = bucketOf(table.slots[table.buckets[next] - 1].process->id);
+        if (((next - home) & table.bucket_mask) >= ((next - hole) & table.bucket_mask)) {
+            table.buckets[hole] = table.buckets[next];
+            hole = next;
+        }
+    }
+    table.buckets[hole] = 0;
+
+    // Free the slot; the new generation invalidates the process's handles
+    table.slots[slot].process = NULL;
+    table.slots[slot].generation++;
+    table.slots[slot].next_free = table.free_slot;
+    table.free_slot = slot;
+    table.count--;
+    return process;
+}
+
+// Function to find a process by its pid
+Process* findProcessById(int pid) {
+    int bucket = findBucket(pid);
+    return bucket == -1 ? NULL : table.slots[table.buckets[bucket] - 1].process;
+}
+
+// Function to get the handle of a process by its pid
+ProcessHandle findProcessHandle(int pid) {
+    int bucket = findBucket(pid);
+    if (bucket == -1) return PROCESS_HANDLE_NONE;
+    int slot = table.buckets[bucket] - 1;
+    return (ProcessHandle){slot, table.slots[slot].generation};
+}
+
+// Function to resolve a handle to its process
+Process* lookupProcess(ProcessHandle handle) {
+    if (handle.slot < 0 || handle.slot >= table.slot_count || table.slots[handle.slot].generation != handle.generation) {
+        return NULL;
+    }
+    return table.slots[handle.slot].process;
+}
+
+// Function to iterate over the registered processes in slot order
+Process* nextProcess(int* cursor) {
+    while (*cursor < table.slot_count) {
+        Process* process = table.slots[(*cursor)++].process;
+        if (process != NULL) return process;
+    }
+    return NULL;
+}
+
+// Function to count the registered processes
+int countProcesses(void) {
+    return table.count;
+}
+
+// Function to get the process table
+const ProcessTable* getProcessTable(void) {
+    return &table;
+}
+
+// Function to replace the process table with a copy of a saved one
+int restoreProcessTable(const ProcessTable* saved) {
+    ProcessSlot* slots = NULL;
+    int* buckets = NULL;
+    int capacity = 0;
+    if (saved->buckets != NULL) { // The saved table had a process registered at some point
+        capacity = saved->slot_count > 0 ? saved->slot_count : 1;
+        slots = malloc(capacity * sizeof(ProcessSlot));
+        buckets = malloc((saved->bucket_mask + 1) * sizeof(int));
+        if (slots == NULL || buckets == NULL) {
+            free(slots);
+            free(buckets);
+            return -1;
+        }
+        memcpy(slots, saved->slots, saved->slot_count * sizeof(ProcessSlot));
+        memcpy(buckets, saved->buckets, (saved->bucket_mask + 1) * sizeof(int));
+    }
+
+    freeProcessTable();
+    table = *saved;
+    table.slots = slots;
+    table.slot_capacity = capacity;
+    table.buckets = buckets;
+    return 0;
+}
+
+// Function to release the process table
+void freeProcessTable(void) {
+    free(table.slots);
+    free(table.buckets);
+    table = (ProcessTable){.free_slot = -1, .bucket_mask = -1};
+}
@@ -0,0 +1,126 @@
+#include "page_table.h"
+
+#ifndef PROCESS_TABLE_H
+#define PROCESS_TABLE_H
+
+// Number of slots and hash buckets the process table starts with; both double as processes are registered
+#define PROCESS_TABLE_INITIAL_CAPACITY 64
+
+/**
+ * Define the ProcessHandle structure, a reference to a registered process that is resolved without hashing its pid.
+ * A slot is reused once its process is unregistered, so the handle also carries the generation of the slot at
+ * registration: a handle to an unregistered process resolves to NULL even when a new process lives in its slot.
+**/
+typedef struct ProcessHandle {
+    int slot;                   // Slot of the process in the table, -1 for no process
+    unsigned int generation;    // Generation of the slot when the process was registered
+} ProcessHandle;
+
+// Handle that never resolves to a process
+#define PROCESS_HANDLE_NONE ((ProcessHandle){-1, 0})
+
+// Define the ProcessSlot structure, the place of a process in the table
+typedef struct ProcessSlot {
+    Process* process;           // Registered process, NULL while the slot is free
+    unsigned int generation;    // Incremented every time the slot is freed
+    int next_free;              // Next free slot while the slot is free, -1 at the end of the list
+} ProcessSlot;
+
+/**
+ * Define the ProcessTable structure, the registry of the live processes.
+ * Processes are stored in slots that never move, so handles stay valid; freed slots are reused from a free list.
+ * Pids map to slots through an open-addressing hash index with linear probing, kept at most half full, whose
+ * buckets are emptied by shifting the rest of the probe run back instead of leaving tombstones. Registration,
+ * lookup and removal are O(1) on average, and the table grows without a limit on the number of processes.
+**/
+typedef struct ProcessTable {
+    ProcessSlot* slots;         // Slots, of which slot_count have been used so far
+    int slot_capacity;          // Number of slots allocated
+    int slot_count;             // Slots in use or on the free list; iteration stops here
+    int free_slot;              // First free slot below slot_count, -1 if none
+    int* buckets;               // Hash index: slot + 1 of the process hashed to each bucket, 0 if the bucket is empty
+    int bucket_mask;            // Number of buckets - 1, the number of buckets being a power of two
+    int count;                  // Number of registered processes
+} ProcessTable;
+
+/**
+ * registerProcess function adds a process to the process table, growing the table if needed.
+ * Returns the process's handle, or PROCESS_HANDLE_NONE if a process with the same pid is registered
+ * or the table cannot grow.
+
+   Parameters:
+   - process: The process to register, which must stay allocated until it is unregistered.
+**/
+ProcessHandle registerProcess(Process* process);
+
+/**
+ * unregisterProcess function removes the process with the given pid from the process table, invalidating its handles.
+ * Returns the removed process, or NULL if no process has that pid.
+
+   Parameters:
+   - pid: The ID of the process to remove.
+**/
+Process* unregisterProcess(int pid);
+
+/**
+ * findProcessById function returns the registered process with the given pid, or NULL if there is none.
+
+   Parameters:
+   - pid: The ID of the process to find.
+**/
+Process* findProcessById(int pid);
+
+/**
+ * findProcessHandle function returns the handle of the registered process with the given pid,
+ * or PROCESS_HANDLE_NONE if there is none.
+
+   Parameters:
+   - pid: The ID of the process to find.
+**/
+ProcessHandle findProcessHandle(int pid);
+
+/**
+ * lookupProcess function resolves a handle with a single slot access. Returns NULL if the handle's process
+ * has been unregistered since the handle was obtained.
+
+   Parameters:
+   - handle: The handle to resolve.
+**/
+Process* lookupProcess(ProcessHandle handle);
+
+/**
+ * nextProcess function returns the first registered process in a slot at or after *cursor, in slot order,
+ * and moves *cursor past it. Returns NULL once every process has been returned.
+ * Iterate over every process with: for (int cursor = 0; (process = nextProcess(&cursor)); )
+
+   Parameters:
+   - cursor: The slot to start from; 0 to start from the first process.
+**/
+Process* nextProcess(int* cursor);
+
+/**
+ * countProcesses function returns the number of registered processes.
+**/
+int countProcesses(void);
+
+/**
+ * getProcessTable function returns the process table, for saving it to a state image (see snapshot.h).
+**/
+const ProcessTable* getProcessTable(void);
+
+/**
+ * restoreProcessTable function replaces the process table with a copy of a saved one, keeping every process in its
+ * slot with its slot's generation, so handles obtained before the table was saved resolve the same way.
+ * Returns 0 on success, or -1 if the copy cannot be allocated, leaving the process table as it was.
+
+   Parameters:
+   - saved: The table to copy, whose slots point to the processes.
+**/
+int restoreProcessTable(const ProcessTable* saved);
+
+/**
+ * freeProcessTable function releases the process table. The processes themselves are not destroyed.
+**/
+void freeProcessTable(void);
+
+#endif // PROCESS_TABLE_H
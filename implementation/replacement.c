@@ -0,0 +1,479 @@
+#include <stdio.h>  // For printf
+#include <stdlib.h> // For dynamic memory allocation
+#include <string.h> // For strcmp
+#include "replacement.h"
+#include "process_table.h"
+#include "tlb.h"
+#include "swap.h"
+#include "event_trace.h"
+
+
+// Global variables defined in main.c
+extern int page_evictions;
+
+// Define the FrameSharer structure, a further page mapping a frame that is shared after a fork
+typedef struct FrameSharer {
+    Process* process;
+    long long vpn;
+    struct FrameSharer* next;
+} FrameSharer;
+
+// Define the SavedReplacement structure, the engine's state in a state image: this header, a SavedFrame per frame,
+// then a SavedSharer per further page mapping a shared frame
+typedef struct SavedReplacement {
+    char policy[16];            // Name of the policy
+    int num_frames;
+    int queue_head, queue_tail;
+    int clock_hand, clock_count;
+    int cleaner_hand;
+    long long sharers;          // Number of SavedSharers
+} SavedReplacement;
+
+typedef struct SavedFrame {
+    long long vpn;
+    ProcessHandle owner;        // PROCESS_HANDLE_NONE if the frame is not mapped
+    int queue_prev, queue_next;
+    bool queued, clock_resident;
+} SavedFrame;
+
+typedef struct SavedSharer {
+    long long vpn;
+    ProcessHandle process;
+    int frame;
+} SavedSharer;
+
+// Reverse map from frame to the pages mapped to it
+static Process** frame_process = NULL;      // Owning process, NULL if the frame is not mapped
+static long long* frame_vpn = NULL;         // Per-process virtual page number mapped to the frame
+static FrameSharer** frame_sharers = NULL;  // Pages mapping the frame besides the owner's, NULL unless shared
+static int num_frames = 0;                  // Number of frames the arrays of this file cover
+
+static const ReplacementPolicy* policy = NULL;
+
+static int cleaner_hand = 0; // Next frame the page cleaner looks at
+
+
+// ---------------------------------------------------------------------------
+// Frame queue shared by FIFO and LRU: a doubly linked list threaded through
+// arrays indexed by frame ID, so every operation is O(1)
+// ---------------------------------------------------------------------------
+
+static int* queue_prev = NULL;
+static int* queue_next = NULL;
+static bool* queued = NULL;
+static int queue_head = -1; // Oldest (FIFO) or least recently used (LRU) frame
+static int queue_tail = -1; // Newest (FIFO) or most recently used (LRU) frame
+
+static void queueReset(void) {
+    memset(queued, 0, num_frames * sizeof(bool));
+    queue_head = queue_tail = -1;
+}
+
+static void queuePushBack(int frameID) {
+    queue_prev[frameID] = queue_tail;
+    queue_next[frameID] = -1;
+    if (queue_tail != -1) {
+        queue_next[queue_tail] = frameID;
+    } else {
+        queue_head = frameID;
+    }
+    queue_tail = frameID;
+    queued[frameID] = true;
+}
+
+static void queueRemove(int frameID) {
+    if (!queued[frameID]) return;
+    if (queue_prev[frameID] != -1) {
+        queue_next[queue_prev[frameID]] = queue_next[frameID];
+    } else {
+        queue_head = queue_next[frameID];
+    }
+    if (queue_next[frameID] != -1) {
+        queue_prev[queue_next[frameID]] = queue_prev[frameID];
+    } else {
+        queue_tail = queue_prev[frameID];
+    }
+    queued[frameID] = false;
+}
+
+static int queueFront(void) {
+    return queue_head;
+}
+
+// FIFO: evict the frame that was mapped first; accesses do not change the order
+static void fifoOnAccess(int frameID) {
+    (void)frameID;
+}
+
+static void fifoOnMap(int frameID) {
+    queueRemove(frameID);
+    queuePushBack(frameID);
+}
+
+// LRU: every access moves the frame to the back of the queue
+static void lruOnAccess(int frameID) {
+    if (!queued[frameID] || frameID == queue_tail) return;
+    queueRemove(frameID);
+    queuePushBack(frameID);
+}
+
+
+// ---------------------------------------------------------------------------
+// Clock: a hand sweeps the frames, giving every frame whose page was
+// referenced since the last sweep a second chance
+// ---------------------------------------------------------------------------
+
+static bool* clock_resident = NULL;
+static int clock_hand = 0;
+static int clock_count = 0; // Number of resident frames
+
+static void clockReset(void) {
+    memset(clock_resident, 0, num_frames * sizeof(bool));
+    clock_hand = 0;
+    clock_count = 0;
+}
+
+static void clockOnAccess(int frameID) {
+    (void)frameID; // The reference bit is set on the PageTableEntry by accessMemory
+}
+
+static void clockOnMap(int frameID) {
+    if (!clock_resident[frameID]) {
+        clock_resident[frameID] = true;
+        clock_count++;
+    }
+}
+
+static void clockOnUnmap(int frameID) {
+    if (clock_resident[frameID]) {
+        clock_resident[frameID] = false;
+        clock_count--;
+    }
+}
+
+// Function to test and clear the reference bit of one page mapped to a frame.
+// The page's TLB entry is dropped as well, so the next access walks the page table and sets the bit again.
+static bool testAndClearPageReferenced(Process* process, long long vpn) {
+    PageTableEntry* entry = lookupPageTableEntry(process, vpn);
+    if (entry == NULL || !(*entry & PTE_REFERENCED)) return false;
+
+    *entry &= ~PTE_REFERENCED;
+    tlbInvalidatePage(process->id, vpn);
+    return true;
+}
+
+// Function to test and clear the reference bits of every page mapped to a frame: a shared frame
+// counts as referenced if any of its pages was
+static bool testAndClearReferenced(int frameID) {
+    bool referenced = testAndClearPageReferenced(frame_process[frameID], frame_vpn[frameID]);
+    for (FrameSharer* sharer = frame_sharers[frameID]; sharer != NULL; sharer = sharer->next) {
+        referenced |= testAndClearPageReferenced(sharer->process, sharer->vpn);
+    }
+    return referenced;
+}
+
+static int clockSelectVictim(void) {
+    if (clock_count == 0) return -1;
+
+    // Every resident frame loses its reference bit on the first pass, so two sweeps always find a victim
+    for (long long step = 0; step < 2LL * num_frames; step++) {
+        int frameID = clock_hand;
+        clock_hand = clock_hand + 1 == num_frames ? 0 : clock_hand + 1;
+        if (clock_resident[frameID] && !testAndClearReferenced(frameID)) {
+            return frameID;
+        }
+    }
+    return -1;
+}
+
+
+static const ReplacementPolicy policies[] = {
+    { "fifo",  queueReset, queueFront,        fifoOnAccess,  fifoOnMap,   queueRemove  },
+    { "lru",   queueReset, queueFront,        lruOnAccess,   fifoOnMap,   queueRemove  },
+    { "clock", clockReset, clockSelectVictim, clockOnAccess, clockOnMap,  clockOnUnmap },
+};
+
+
+// Function to select the page replacement policy and size its per-frame arrays
+int initializeReplacement(const char* policyName, int numFrames) {
+    const ReplacementPolicy* selected = NULL;
+    for (size_t i = 0; i < sizeof(policies) / sizeof(policies[0]); i++) {
+        if (strcmp(policies[i].name, policyName) == 0) {
+            selected = &policies[i];
+        }
+    }
+    if (selected == NULL || numFrames <= 0) return -1; // Unknown policy
+
+    freeReplacement();
+    frame_process = calloc(numFrames, sizeof(Process*));
+    frame_vpn = malloc(numFrames * sizeof(long long));
+    frame_sharers = calloc(numFrames, sizeof(FrameSharer*));
+    queue_prev = malloc(numFrames * sizeof(int));
+    queue_next = malloc(numFrames * sizeof(int));
+    queued = malloc(numFrames * sizeof(bool));
+    clock_resident = malloc(numFrames * sizeof(bool));
+    if (!frame_process || !frame_vpn || !frame_sharers || !queue_prev || !queue_next || !queued || !clock_resident) {
+        freeReplacement();
+        return -1;
+    }
+    num_frames = numFrames;
+    cleaner_hand = 0;
+
+    policy = selected;
+    queueReset();
+    clockReset();
+    return 0;
+}
+
+// Function to forget the sharers of a frame
+static void freeSharers(int frameID) {
+    while (frame_sharers[frameID] != NULL) {
+        FrameSharer* sharer = frame_sharers[frameID];
+        frame_sharers[frameID] = sharer->next;
+        free(sharer);
+    }
+}
+
+// Function to release the per-frame arrays
+void freeReplacement(void) {
+    for (int frameID = 0; frame_sharers && frameID < num_frames; frameID++) {
+        freeSharers(frameID);
+    }
+    free(frame_process);
+    free(frame_vpn);
+    free(frame_sharers);
+    free(queue_prev);
+    free(queue_next);
+    free(queued);
+    free(clock_resident);
+    frame_process = NULL;
+    frame_vpn = NULL;
+    frame_sharers = NULL;
+    queue_prev = queue_next = NULL;
+    queued = clock_resident = NULL;
+    num_frames = 0;
+    policy = NULL;
+}
+
+// Function to get the active replacement policy
+const ReplacementPolicy* getReplacementPolicy(void) {
+    return policy;
+}
+
+// Function to record a newly mapped frame
+void replacementOnMap(int frameID, Process* process, long long vpn) {
+    frame_process[frameID] = process;
+    frame_vpn[frameID] = vpn;
+    if (policy) policy->on_map(frameID);
+}
+
+// Function to record an access to a mapped frame
+void replacementOnAccess(int frameID) {
+    if (policy) policy->on_access(frameID);
+}
+
+// Function to record a further page mapping a mapped frame
+int replacementOnShare(int frameID, Process* process, long long vpn) {
+    FrameSharer* sharer = malloc(sizeof(FrameSharer));
+    if (sharer == NULL) return -1;
+    sharer->process = process;
+    sharer->vpn = vpn;
+    sharer->next = frame_sharers[frameID];
+    frame_sharers[frameID] = sharer;
+    return 0;
+}
+
+// Function to forget one of the pages mapping a shared frame; a sharer takes over from an owner that leaves
+void replacementOnUnshare(int frameID, Process* process, long long vpn) {
+    FrameSharer** link = &frame_sharers[frameID];
+    if (frame_process[frameID] == process && frame_vpn[frameID] == vpn) {
+        if (*link == NULL) return; // Not shared: the owner keeps the frame
+        frame_process[frameID] = (*link)->process;
+        frame_vpn[frameID] = (*link)->vpn;
+    } else {
+        while (*link != NULL && ((*link)->process != process || (*link)->vpn != vpn)) link = &(*link)->next;
+        if (*link == NULL) return;
+    }
+    FrameSharer* sharer = *link;
+    *link = sharer->next;
+    free(sharer);
+}
+
+// Function to record an unmapped frame
+void replacementOnUnmap(int frameID) {
+    if (frame_process[frameID] == NULL) return;
+    frame_process[frameID] = NULL;
+    freeSharers(frameID);
+    if (policy) policy->on_unmap(frameID);
+}
+
+// Function to take a victim frame away from one of the pages mapped to it. The page is marked swapped if slot
+// holds its contents.
+static void unmapVictimPage(Process* process, long long vpn, int frameID, int slot, PhysicalMemory* pm) {
+    TRACE_EVENT(EVENT_LEVEL_PAGING, EVENT_EVICT, process->id, vpn, frameID);
+    splitHugePage(process, vpn, pm); // Only the victim's page of a huge page leaves memory
+    PageTableEntry* entry = lookupPageTableEntry(process, vpn);
+    if (entry != NULL) {
+        readaheadOnUnmap(process, entry);
+        pteSetFrame(entry, -1);
+        *entry &= ~(PTE_REFERENCED | PTE_DIRTY | PTE_COW); // The page gets a private frame when it is faulted back in
+        if (slot != -1) {
+            *entry |= PTE_SWAPPED;
+            swapSetPageSlot(lookupPageId(process, vpn), slot);
+        }
+    }
+    tlbInvalidatePage(process->id, vpn);
+    process->resident_pages--;
+}
+
+// Function to add a page mapping a victim frame to what is known of the frame: whether it is dirty, and a slot
+// already holding its contents
+static void inspectVictimPage(Process* process, long long vpn, bool* dirty, int* slot) {
+    PageTableEntry* entry = lookupPageTableEntry(process, vpn);
+    if (entry != NULL && (*entry & PTE_DIRTY)) *dirty = true;
+    if (*slot == -1) *slot = swapSlotOf(lookupPageId(process, vpn));
+}
+
+// Function to save the contents of a victim frame to swap, if there is a swap device. The frame is dirty if any
+// page mapping it was written, and its contents are already in swap if one of them has a slot.
+// Returns the slot holding the contents, or -1 if there is none.
+static int swapOutVictim(int frameID) {
+    if (!swapEnabled()) return -1;
+
+    bool dirty = false;
+    int slot = -1;
+    inspectVictimPage(frame_process[frameID], frame_vpn[frameID], &dirty, &slot);
+    for (FrameSharer* sharer = frame_sharers[frameID]; sharer != NULL; sharer = sharer->next) {
+        inspectVictimPage(sharer->process, sharer->vpn, &dirty, &slot);
+    }
+    return swapOut(slot, dirty);
+}
+
+// Function to evict the policy's victim and free its frame
+int evictPage(PhysicalMemory* pm) {
+    if (!policy) return -1;
+
+    int frameID = policy->select_victim();
+    if (frameID == -1) return -1;
+
+    // Invalidate the PageTableEntries of the victim's pages and any cached translation of them
+    int slot = swapOutVictim(frameID);
+    unmapVictimPage(frame_process[frameID], frame_vpn[frameID], frameID, slot, pm);
+    for (FrameSharer* sharer = frame_sharers[frameID]; sharer != NULL; sharer = sharer->next) {
+        unmapVictimPage(sharer->process, sharer->vpn, frameID, slot, pm);
+    }
+
+    freePhysicalFrame(frameID, pm); // Forgets the frame's pages in the reverse map and returns it to the buddy allocator
+    page_evictions++;
+    return frameID;
+}
+
+// Function to write dirty pages out ahead of demand, so that evicting them later costs no write
+void cleanDirtyPages(PhysicalMemory* pm) {
+    if (!swapEnabled() || num_frames == 0) return;
+    if ((pm->remaining_memory >> pm->config.page_shift) * SWAP_CLEAN_WATERMARK >= num_frames) return;
+    if (!swapWritebackIdle()) return; // Writing evicted pages comes first
+
+    int cleaned = 0;
+    for (int scanned = 0; scanned < SWAP_CLEAN_SCAN && cleaned < SWAP_CLEAN_BATCH; scanned++) {
+        int frameID = cleaner_hand;
+        cleaner_hand = (cleaner_hand + 1) % num_frames;
+
+        // Shared frames are left to eviction, which knows whether any of their pages is dirty
+        Process* process = frame_process[frameID];
+        if (process == NULL || frame_sharers[frameID] != NULL) continue;
+        PageTableEntry* entry = lookupPageTableEntry(process, frame_vpn[frameID]);
+        if (entry == NULL || (*entry & (PTE_PRESENT | PTE_DIRTY | PTE_SLAB)) != (PTE_PRESENT | PTE_DIRTY)) continue;
+
+        if (swapClean(lookupPageId(process, frame_vpn[frameID])) == -1) return; // The swap device is full
+        *entry &= ~PTE_DIRTY;
+        cleaned++;
+    }
+}
+
+// Function to count the pages mapping shared frames besides their owners
+static long long countSharers(void) {
+    long long sharers = 0;
+    for (int frameID = 0; frameID < num_frames; frameID++) {
+        for (FrameSharer* sharer = frame_sharers[frameID]; sharer != NULL; sharer = sharer->next) sharers++;
+    }
+    return sharers;
+}
+
+// Function to get the size of the engine's state in a state image
+size_t replacementStateSize(void) {
+    return sizeof(SavedReplacement) + num_frames * sizeof(SavedFrame) + countSharers() * sizeof(SavedSharer);
+}
+
+// Function to write the engine's state for a state image
+void saveReplacementState(void* buffer) {
+    SavedReplacement* saved = buffer;
+    SavedFrame* frames = (SavedFrame*)(saved + 1);
+    SavedSharer* sharers = (SavedSharer*)(frames + num_frames);
+
+    memset(saved, 0, sizeof(SavedReplacement));
+    if (policy) snprintf(saved->policy, sizeof(saved->policy), "%s", policy->name);
+    saved->num_frames = num_frames;
+    saved->queue_head = queue_head;
+    saved->queue_tail = queue_tail;
+    saved->clock_hand = clock_hand;
+    saved->clock_count = clock_count;
+    saved->cleaner_hand = cleaner_hand;
+
+    for (int frameID = 0; frameID < num_frames; frameID++) {
+        Process* owner = frame_process[frameID];
+        frames[frameID] = (SavedFrame){
+            .vpn = owner ? frame_vpn[frameID] : -1,
+            .owner = owner ? findProcessHandle(owner->id) : PROCESS_HANDLE_NONE,
+            .queue_prev = queue_prev[frameID],
+            .queue_next = queue_next[frameID],
+            .queued = queued[frameID],
+            .clock_resident = clock_resident[frameID],
+        };
+        for (FrameSharer* sharer = frame_sharers[frameID]; sharer != NULL; sharer = sharer->next) {
+            *sharers++ = (SavedSharer){ sharer->vpn, findProcessHandle(sharer->process->id), frameID };
+            saved->sharers++;
+        }
+    }
+}
+
+// Function to restore the engine's state from a state image
+int loadReplacementState(const void* buffer, size_t size) {
+    const SavedReplacement* saved = buffer;
+    if (size < sizeof(SavedReplacement) || saved->num_frames <= 0 || saved->sharers < 0
+        || size != sizeof(SavedReplacement) + saved->num_frames * sizeof(SavedFrame) + saved->sharers * sizeof(SavedSharer)) {
+        return -1;
+    }
+    char name[sizeof(saved->policy)];
+    snprintf(name, sizeof(name), "%.*s", (int)sizeof(name) - 1, saved->policy);
+    if (initializeReplacement(name, saved->num_frames) != 0) return -1;
+
+    const SavedFrame* frames = (const SavedFrame*)(saved + 1);
+    for (int frameID = 0; frameID < num_frames; frameID++) {
+        if (frames[frameID].owner.slot != -1) {
+            frame_process[frameID] = lookupProcess(frames[frameID].owner);
+            if (frame_process[frameID] == NULL) return -1;
+        }
+        frame_vpn[frameID] = frames[frameID].vpn;
+        queue_prev[frameID] = frames[frameID].queue_prev;
+        queue_next[frameID] = frames[frameID].queue_next;
+        queued[frameID] = frames[frameID].queued;
+        clock_resident[frameID] = frames[frameID].clock_resident;
+    }
+    queue_head = saved->queue_head;
+    queue_tail = saved->queue_tail;
+    clock_hand = saved->clock_hand;
+    clock_count = saved->clock_count;
+    cleaner_hand = saved->cleaner_hand;
+
+    // Sharers are pushed at the head of their frame's list, so restore them last to first to keep the saved order
+    const SavedSharer* sharers = (const SavedSharer*)(frames + num_frames);
+    for (long long i = saved->sharers - 1; i >= 0; i--) {
+        Process* process = lookupProcess(sharers[i].process);
+        if (process == NULL || sharers[i].frame < 0 || sharers[i].frame >= num_frames
+            || replacementOnShare(sharers[i].frame, process, sharers[i].vpn) != 0) {
+            return -1;
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,137 @@
+#include "page_table.h"
+
+#ifndef REPLACEMENT_H
+#define REPLACEMENT_H
+
+/**
+ * Define the ReplacementPolicy structure, the interface every page replacement policy implements.
+ * The engine tells the policy when a frame is mapped, accessed or unmapped, and asks it for a victim
+ * when physical memory is full. on_access runs on every memory access, so it must be O(1).
+**/
+typedef struct ReplacementPolicy {
+    const char* name;                   // Name used to select the policy at startup
+    void (*reset)(void);                // Forget every frame
+    int (*select_victim)(void);         // Return the frame to evict, -1 if no frame is mapped
+    void (*on_access)(int frameID);     // A mapped frame was accessed
+    void (*on_map)(int frameID);        // A frame was mapped to a page
+    void (*on_unmap)(int frameID);      // A frame was unmapped (evicted, deallocated or freed)
+} ReplacementPolicy;
+
+/**
+ * initializeReplacement function selects the page replacement policy by name ("fifo", "lru" or "clock")
+ * and allocates the engine's reverse map and the policies' per-frame state for numFrames frames.
+ * Returns 0 on success, or -1 if the name is unknown or the arrays cannot be allocated.
+
+   Parameters:
+   - policyName: The name of the policy to use.
+   - numFrames: The number of frames in physical memory.
+**/
+int initializeReplacement(const char* policyName, int numFrames);
+
+/**
+ * freeReplacement function releases the engine's per-frame arrays; no policy is active afterwards.
+**/
+void freeReplacement(void);
+
+/**
+ * getReplacementPolicy function returns the active replacement policy.
+**/
+const ReplacementPolicy* getReplacementPolicy(void);
+
+/**
+ * replacementOnMap function records that frameID now backs page vpn of process, so the page can be found
+ * again when the frame is chosen as a victim, and passes the event on to the policy.
+
+   Parameters:
+   - frameID: The frame that was mapped.
+   - process: The process that owns the page.
+   - vpn: The per-process virtual page number mapped to the frame.
+**/
+void replacementOnMap(int frameID, Process* process, long long vpn);
+
+/**
+ * replacementOnShare function records that frameID, already mapped, now also backs page vpn of process, as when a
+ * forked process shares its parent's frames. Every page mapping a frame loses it when the frame is evicted.
+ * Returns 0 on success, or -1 if the reverse map entry cannot be allocated.
+
+   Parameters:
+   - frameID: The shared frame.
+   - process: The process whose page now maps the frame.
+   - vpn: The per-process virtual page number mapped to the frame.
+**/
+int replacementOnShare(int frameID, Process* process, long long vpn);
+
+/**
+ * replacementOnUnshare function forgets that page vpn of process maps frameID, which stays mapped by its other pages.
+ * It has no effect on a frame mapped by that page alone; use replacementOnUnmap when the frame itself is freed.
+
+   Parameters:
+   - frameID: The shared frame.
+   - process: The process whose page no longer maps the frame.
+   - vpn: The per-process virtual page number that mapped the frame.
+**/
+void replacementOnUnshare(int frameID, Process* process, long long vpn);
+
+/**
+ * replacementOnAccess function passes an access to a mapped frame on to the policy.
+
+   Parameters:
+   - frameID: The frame that was accessed.
+**/
+void replacementOnAccess(int frameID);
+
+/**
+ * replacementOnUnmap function forgets the owner of frameID and passes the event on to the policy.
+ * Unmapping a frame that is not mapped has no effect.
+
+   Parameters:
+   - frameID: The frame that was unmapped.
+**/
+void replacementOnUnmap(int frameID);
+
+/**
+ * evictPage function asks the policy for a victim frame, invalidates the PageTableEntries and TLB entries
+ * of the pages mapped to it, and frees the frame. Returns the freed frame ID, or -1 if no frame is mapped.
+
+   Parameters:
+   - pm: A pointer to the PhysicalMemory structure.
+**/
+int evictPage(PhysicalMemory* pm);
+
+/**
+ * cleanDirtyPages function writes dirty pages to the swap device ahead of their eviction, as a second hand sweeping
+ * the frames, while fewer than 1/SWAP_CLEAN_WATERMARK of the frames are free and the writeback thread is idle.
+ * It looks at SWAP_CLEAN_SCAN frames and cleans SWAP_CLEAN_BATCH pages at most. Does nothing without a swap device.
+
+   Parameters:
+   - pm: A pointer to the PhysicalMemory structure.
+**/
+void cleanDirtyPages(PhysicalMemory* pm);
+
+/**
+ * replacementStateSize function returns the number of bytes saveReplacementState writes.
+**/
+size_t replacementStateSize(void);
+
+/**
+ * saveReplacementState function writes the active policy's name, the reverse map and the policies' per-frame state
+ * to buffer, for a state image (see snapshot.h). Processes are recorded by their handles in the process table.
+
+   Parameters:
+   - buffer: replacementStateSize() bytes, aligned to 8 bytes.
+**/
+void saveReplacementState(void* buffer);
+
+/**
+ * loadReplacementState function replaces the engine's state with one written by saveReplacementState, selecting
+ * the policy it was saved with. The process table the handles refer to must have been restored first.
+ * Returns 0 on success, or -1 if the state is malformed or the arrays cannot be allocated, after which the engine
+ * must be initialized again.
+
+   Parameters:
+   - buffer: The saved state, aligned to 8 bytes.
+   - size: The number of bytes in buffer.
+**/
+int loadReplacementState(const void* buffer, size_t size);
+
+#endif // REPLACEMENT_H
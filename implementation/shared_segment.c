@@ -0,0 +1,291 @@
+#include <stdio.h>  // For printf
+#include <stdlib.h> // For dynamic memory allocation
+#include <string.h> // For strcmp
+#include "shared_segment.h"
+#include "process_table.h"
+#include "tlb.h"
+
+
+// Segments with at least one process attached
+static SharedSegment* segments = NULL;
+
+// Segment page resident in each frame, NULL for frames that do not hold a segment page
+static SharedSegment** frame_segments = NULL;
+static long long* frame_segment_pages = NULL;
+static long long num_frames = 0;
+
+
+// Function to set up the segment registry over a physical memory
+int initializeSharedSegments(PhysicalMemory* pm) {
+    freeSharedSegments();
+    frame_segments = calloc(pm->config.num_frames, sizeof(SharedSegment*));
+    frame_segment_pages = malloc(pm->config.num_frames * sizeof(long long));
+    if (frame_segments == NULL || frame_segment_pages == NULL) {
+        freeSharedSegments();
+        return -1;
+    }
+    num_frames = pm->config.num_frames;
+    return 0;
+}
+
+// Function to free a segment's own memory
+static void freeSegment(SharedSegment* segment) {
+    free(segment->page_ids);
+    free(segment->frames);
+    free(segment);
+}
+
+// Function to release the registry
+void freeSharedSegments(void) {
+    while (segments != NULL) {
+        SharedSegment* next = segments->next;
+        freeSegment(segments);
+        segments = next;
+    }
+    free(frame_segments);
+    free(frame_segment_pages);
+    frame_segments = NULL;
+    frame_segment_pages = NULL;
+    num_frames = 0;
+}
+
+// Function to find a segment by name
+static SharedSegment* findSegment(const char* name) {
+    for (SharedSegment* segment = segments; segment != NULL; segment = segment->next) {
+        if (strcmp(segment->name, name) == 0) return segment;
+    }
+    return NULL;
+}
+
+// Function to create a segment and reserve its virtual pages
+static SharedSegment* createSegment(const char* name, long long size, VirtualMemory* vm) {
+    if (size > vm->remaining_memory) return NULL;
+    SharedSegment* segment = calloc(1, sizeof(SharedSegment));
+    if (segment == NULL) return NULL;
+
+    snprintf(segment->name, SEGMENT_NAME_LENGTH, "%s", name);
+    segment->size = size;
+    segment->num_pages = (size + vm->config.page_mask) >> vm->config.page_shift;
+    segment->page_ids = malloc(segment->num_pages * sizeof(long long));
+    segment->frames = malloc(segment->num_pages * sizeof(int));
+    if (!segment->page_ids || !segment->frames || allocatePages(vm, segment->num_pages, segment->page_ids) == -1) {
+        freeSegment(segment);
+        return NULL;
+    }
+
+    // Every page is in use but the last, which only has the chunks the size covers
+    for (long long i = 0; i < segment->num_pages; i++) {
+        long long bytesInPage = size - (i << vm->config.page_shift);
+        if (bytesInPage > vm->config.page_size) bytesInPage = vm->config.page_size;
+        int chunks = (bytesInPage + vm->config.chunk_size - 1) >> vm->config.chunk_shift;
+        vm->allocated_chunks[segment->page_ids[i]] = (1u << chunks) - 1;
+        segment->frames[i] = -1;
+    }
+    vm->remaining_memory -= size;
+
+    segment->next = segments;
+    segments = segment;
+    return segment;
+}
+
+// Function to take a segment out of the registry and give back its virtual pages, once no process is attached
+static void destroySegment(SharedSegment* segment, VirtualMemory* vm) {
+    SharedSegment** link = &segments;
+    while (*link != segment) link = &(*link)->next;
+    *link = segment->next;
+
+    for (long long i = 0; i < segment->num_pages; i++) {
+        freeVirtualPage(segment->page_ids[i], vm);
+    }
+    vm->remaining_memory += segment->size;
+    freeSegment(segment);
+}
+
+// Function to find the attachment of a process covering vpn
+static SegmentAttachment* findAttachment(const Process* process, long long vpn) {
+    for (SegmentAttachment* attachment = process->attachments; attachment != NULL; attachment = attachment->next) {
+        if (vpn >= attachment->base_vpn && vpn < attachment->base_vpn + attachment->segment->num_pages) {
+            return attachment;
+        }
+    }
+    return NULL;
+}
+
+// Function to attach a segment to a process, creating the segment if needed
+int attachSegment(int processId, const char* name, long long size, long long baseVpn, VirtualMemory* vm) {
+    Process* process = findProcessById(processId);
+    if (process == NULL) {
+        printf("Process with ID %d not found.\n", processId);
+        return -1;
+    }
+
+    SharedSegment* segment = findSegment(name);
+    if (segment != NULL && size != 0 && size != segment->size) {
+        printf("Segment %s already exists with %lld bytes.\n", name, segment->size);
+        return -1;
+    }
+    long long numPages = segment ? segment->num_pages : (size + vm->config.page_mask) >> vm->config.page_shift;
+    long long processPages = (process->memory_size + vm->config.page_mask) >> vm->config.page_shift;
+    if ((segment == NULL && size <= 0) || baseVpn < processPages || baseVpn + numPages > MAX_VPN) {
+        printf("A segment must have a positive size and lie past the end of the process.\n");
+        return -1;
+    }
+    for (long long vpn = baseVpn; vpn < baseVpn + numPages; vpn++) {
+        PageTableEntry* entry = lookupPageTableEntry(process, vpn);
+        if (entry != NULL && (*entry & PTE_VALID)) {
+            printf("Page %lld of process ID %d is already in use.\n", vpn, processId);
+            return -1;
+        }
+    }
+
+    // Allocate the page tables covering the range first, so nothing needs undoing if page table memory runs out
+    for (long long vpn = baseVpn; vpn < baseVpn + numPages; vpn = (vpn | PAGE_TABLE_INDEX_MASK) + 1) {
+        if (findOrCreatePageTable(process->mpt, vpn) == NULL) {
+            printf("Insufficient memory for the page tables of segment %s.\n", name);
+            return -1;
+        }
+    }
+    SegmentAttachment* attachment = malloc(sizeof(SegmentAttachment));
+    if (attachment == NULL || (segment == NULL && (segment = createSegment(name, size, vm)) == NULL)) {
+        printf("Insufficient virtual memory to attach segment %s.\n", name);
+        free(attachment);
+        return -1;
+    }
+
+    // Give the process a PageTableEntry for every page of the segment, backed by the segment's virtual pages
+    for (long long i = 0; i < numPages; i++) {
+        SecondaryPageTable* spt = findOrCreatePageTable(process->mpt, baseVpn + i);
+        int index = PAGE_TABLE_INDEX(baseVpn + i, 0);
+        spt->entries[index] = PTE_EMPTY | PTE_VALID | PTE_SHARED | PTE_PROT_READ | PTE_PROT_WRITE;
+        pteSetChunkMask(&spt->entries[index], vm->allocated_chunks[segment->page_ids[i]]);
+        spt->page_nums[index] = segment->page_ids[i];
+        spt->valid_count++;
+    }
+
+    attachment->segment = segment;
+    attachment->base_vpn = baseVpn;
+    attachment->next = process->attachments;
+    process->attachments = attachment;
+    segment->attachments++;
+    return 0;
+}
+
+// Function to forget an attachment, destroying the segment when no process is attached any more
+static void forgetAttachment(SegmentAttachment* attachment, VirtualMemory* vm) {
+    if (--attachment->segment->attachments == 0) {
+        destroySegment(attachment->segment, vm);
+    }
+    free(attachment);
+}
+
+// Function to detach a segment from a process
+int detachSegment(int processId, const char* name, VirtualMemory* vm, PhysicalMemory* pm) {
+    Process* process = findProcessById(processId);
+    if (process == NULL) {
+        printf("Process with ID %d not found.\n", processId);
+        return -1;
+    }
+
+    SegmentAttachment** link = &process->attachments;
+    while (*link != NULL && strcmp((*link)->segment->name, name) != 0) link = &(*link)->next;
+    if (*link == NULL) {
+        printf("Segment %s is not attached to process ID %d.\n", name, processId);
+        return -1;
+    }
+    SegmentAttachment* attachment = *link;
+    *link = attachment->next;
+
+    // Unmap the process's pages of the segment; a frame no other process maps is freed
+    for (long long i = 0; i < attachment->segment->num_pages; i++) {
+        long long vpn = attachment->base_vpn + i;
+        SecondaryPageTable* spt = findOrCreatePageTable(process->mpt, vpn); // Allocated when the segment was attached
+        PageTableEntry* entry = &spt->entries[PAGE_TABLE_INDEX(vpn, 0)];
+        if (*entry & PTE_PRESENT) {
+            tlbInvalidatePage(process->id, vpn);
+            releaseFrame(process, vpn, pteFrame(*entry), pm);
+            process->resident_pages--;
+        }
+        *entry = PTE_EMPTY;
+        spt->page_nums[PAGE_TABLE_INDEX(vpn, 0)] = -1;
+        spt->valid_count--;
+    }
+    forgetAttachment(attachment, vm);
+    return 0;
+}
+
+// Function to forget every attachment of a process being destroyed
+void detachAllSegments(Process* process, VirtualMemory* vm) {
+    while (process->attachments != NULL) {
+        SegmentAttachment* attachment = process->attachments;
+        process->attachments = attachment->next;
+        forgetAttachment(attachment, vm);
+    }
+}
+
+// Function to give a forked child the attachments of its parent
+int forkSegmentAttachments(const Process* parent, Process* child) {
+    for (SegmentAttachment* attachment = parent->attachments; attachment != NULL; attachment = attachment->next) {
+        SegmentAttachment* copy = malloc(sizeof(SegmentAttachment));
+        if (copy == NULL) return -1;
+        copy->segment = attachment->segment;
+        copy->base_vpn = attachment->base_vpn;
+        copy->next = child->attachments;
+        child->attachments = copy;
+        copy->segment->attachments++;
+    }
+    return 0;
+}
+
+// Function to find the frame a segment page is resident in
+int segmentFrame(const Process* process, long long vpn) {
+    SegmentAttachment* attachment = findAttachment(process, vpn);
+    return attachment ? attachment->segment->frames[vpn - attachment->base_vpn] : -1;
+}
+
+// Function to record the frame a segment page was faulted into
+void segmentSetFrame(const Process* process, long long vpn, int frameID) {
+    SegmentAttachment* attachment = findAttachment(process, vpn);
+    if (attachment == NULL || frame_segments == NULL) return;
+
+    attachment->segment->frames[vpn - attachment->base_vpn] = frameID;
+    frame_segments[frameID] = attachment->segment;
+    frame_segment_pages[frameID] = vpn - attachment->base_vpn;
+}
+
+// Function to forget a freed frame's segment page
+void segmentOnFrameFreed(int frameID) {
+    if (frame_segments == NULL || frameID < 0 || frameID >= num_frames || frame_segments[frameID] == NULL) return;
+    frame_segments[frameID]->frames[frame_segment_pages[frameID]] = -1;
+    frame_segments[frameID] = NULL;
+}
+
+// Function to find the lowest page a process's segments start at
+long long segmentFloor(const Process* process) {
+    long long floor = MAX_VPN;
+    for (SegmentAttachment* attachment = process->attachments; attachment != NULL; attachment = attachment->next) {
+        if (attachment->base_vpn < floor) floor = attachment->base_vpn;
+    }
+    return floor;
+}
+
+// Function to add up the sizes of the segments
+long long sharedSegmentBytes(void) {
+    long long bytes = 0;
+    for (SharedSegment* segment = segments; segment != NULL; segment = segment->next) bytes += segment->size;
+    return bytes;
+}
+
+// Function to print the segments
+void printSharedSegments(void) {
+    if (segments == NULL) {
+        printf("\nNo shared segments.\n");
+        return;
+    }
+    printf("\nShared segments:\n");
+    for (SharedSegment* segment = segments; segment != NULL; segment = segment->next) {
+        long long resident = 0;
+        for (long long i = 0; i < segment->num_pages; i++) resident += segment->frames[i] != -1;
+        printf("Segment %s: %lld bytes, %lld of %lld pages resident, %d processes attached\n",
+               segment->name, segment->size, resident, segment->num_pages, segment->attachments);
+    }
+}
@@ -0,0 +1,144 @@
+#include "page_table.h"
+
+#ifndef SHARED_SEGMENT_H
+#define SHARED_SEGMENT_H
+
+// Longest segment name, including the terminating null character
+#define SEGMENT_NAME_LENGTH 32
+
+/**
+ * Define the SharedSegment structure, a named range of memory several processes map at addresses of their own.
+ * The segment owns the virtual pages backing it, so every attached process's PageTableEntries for it hold the same
+ * page IDs, marked PTE_SHARED. A segment page is resident in at most one frame at a time: the first process to
+ * fault the page in maps a new frame, and the others map the same frame, whose reference count covers them all.
+ * The frame is freed once the last process mapping it unmaps it, detaches or exits; the segment itself goes away
+ * when its last process detaches.
+**/
+typedef struct SharedSegment {
+    char name[SEGMENT_NAME_LENGTH];
+    long long size;                 // Bytes in the segment
+    long long num_pages;            // Pages in the segment
+    long long* page_ids;            // Virtual page backing each page of the segment
+    int* frames;                    // Frame each page is resident in, -1 while it is not
+    int attachments;                // Number of processes attached
+    struct SharedSegment* next;     // Next segment in the registry
+} SharedSegment;
+
+// Define the SegmentAttachment structure, a segment mapped into a process (Process.attachments)
+typedef struct SegmentAttachment {
+    SharedSegment* segment;
+    long long base_vpn;             // Per-process virtual page number of the segment's first page
+    struct SegmentAttachment* next; // Next segment attached to the same process
+} SegmentAttachment;
+
+/**
+ * initializeSharedSegments function sets up an empty segment registry and the map from frames to segment pages.
+ * Returns 0 on success, or -1 if the frame map cannot be allocated.
+
+   Parameters:
+   - pm: A pointer to the PhysicalMemory structure the segments' pages are resident in.
+**/
+int initializeSharedSegments(PhysicalMemory* pm);
+
+/**
+ * freeSharedSegments function releases the registry and the frame map; it does not return pages or frames.
+**/
+void freeSharedSegments(void);
+
+/**
+ * attachSegment function maps the segment called name into a process from page baseVpn on, creating the segment
+ * with size bytes if no process has it attached. The pages are faulted in on first access, sharing the segment's
+ * resident frames. The range must lie past the end of the process and must not overlap another segment.
+ * Returns 0 on success, or -1 (with a message) if the process does not exist, the range is taken, the size
+ * does not match the existing segment's, or virtual memory runs out.
+
+   Parameters:
+   - processId: The ID of the process to attach the segment to.
+   - name: The name of the segment.
+   - size: The size of the segment in bytes; 0 to attach an existing segment whatever its size.
+   - baseVpn: The per-process virtual page number the segment starts at.
+   - vm: A pointer to the VirtualMemory structure.
+**/
+int attachSegment(int processId, const char* name, long long size, long long baseVpn, VirtualMemory* vm);
+
+/**
+ * detachSegment function unmaps the segment called name from a process, releasing its references to the segment's
+ * frames. Returns 0 on success, or -1 if the process does not exist or does not have the segment attached.
+
+   Parameters:
+   - processId: The ID of the process to detach the segment from.
+   - name: The name of the segment.
+   - vm: A pointer to the VirtualMemory structure.
+   - pm: A pointer to the PhysicalMemory structure.
+**/
+int detachSegment(int processId, const char* name, VirtualMemory* vm, PhysicalMemory* pm);
+
+/**
+ * detachAllSegments function forgets every attachment of a process whose PageTableEntries have already been
+ * released, as when it is destroyed, freeing the segments it was the last process attached to.
+
+   Parameters:
+   - process: The process being destroyed.
+   - vm: A pointer to the VirtualMemory structure.
+**/
+void detachAllSegments(Process* process, VirtualMemory* vm);
+
+/**
+ * forkSegmentAttachments function attaches a forked child to every segment its parent has attached, at the same
+ * pages; the child's PageTableEntries are copied along with the rest of its page tables.
+ * Returns 0 on success, or -1 if an attachment cannot be allocated.
+
+   Parameters:
+   - parent: The forked process.
+   - child: The new process.
+**/
+int forkSegmentAttachments(const Process* parent, Process* child);
+
+/**
+ * segmentFrame function returns the frame the segment page mapped at vpn of a process is resident in,
+ * or -1 if it is not resident (or vpn is not a segment page).
+
+   Parameters:
+   - process: The process with the segment attached.
+   - vpn: The per-process virtual page number of the segment page.
+**/
+int segmentFrame(const Process* process, long long vpn);
+
+/**
+ * segmentSetFrame function records that the segment page mapped at vpn of a process is now resident in frameID.
+
+   Parameters:
+   - process: The process that faulted the page in.
+   - vpn: The per-process virtual page number of the segment page.
+   - frameID: The frame the page was mapped to.
+**/
+void segmentSetFrame(const Process* process, long long vpn, int frameID);
+
+/**
+ * segmentOnFrameFreed function forgets a freed frame if it held a segment page; called for every freed frame.
+
+   Parameters:
+   - frameID: The frame that was freed.
+**/
+void segmentOnFrameFreed(int frameID);
+
+/**
+ * segmentFloor function returns the first page of the lowest segment attached to a process, or MAX_VPN if none is,
+ * the limit the process can grow up to.
+
+   Parameters:
+   - process: The process to check.
+**/
+long long segmentFloor(const Process* process);
+
+/**
+ * sharedSegmentBytes function returns the total size in bytes of the segments.
+**/
+long long sharedSegmentBytes(void);
+
+/**
+ * printSharedSegments function prints every segment with its size, resident pages and number of processes attached.
+**/
+void printSharedSegments(void);
+
+#endif // SHARED_SEGMENT_H
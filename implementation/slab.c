@@ -0,0 +1,218 @@
+#include <stdlib.h> // For dynamic memory allocation
+#include <string.h> // For memset
+#include "slab.h"
+#include "replacement.h"
+
+
+// Physical memory the slabs take their frames from
+static PhysicalMemory* slab_pm = NULL;
+
+// Slab resident in each frame, NULL for frames that do not hold a slab
+static Slab** frame_slabs = NULL;
+
+// Slabs with at least one free object, per size class
+static Slab* partial[MAX_CHUNKS_PER_PAGE + 1];
+
+static SlabStats slabStats;
+
+// Define the SavedSlabs structure, the slab allocator in a state image: this header, then count Slabs (with no list
+// links), those on the partial lists first, in list order
+typedef struct SavedSlabs {
+    SlabStats stats;
+    long long count;
+} SavedSlabs;
+
+
+// Function to put a slab at the head of the partial list of its size class
+static void partialPush(Slab* slab) {
+    slab->prev = NULL;
+    slab->next = partial[slab->size_class];
+    if (slab->next) slab->next->prev = slab;
+    partial[slab->size_class] = slab;
+}
+
+// Function to take a slab off the partial list of its size class
+static void partialRemove(Slab* slab) {
+    if (slab->prev) {
+        slab->prev->next = slab->next;
+    } else {
+        partial[slab->size_class] = slab->next;
+    }
+    if (slab->next) slab->next->prev = slab->prev;
+    slab->prev = slab->next = NULL;
+}
+
+// Function to set up the slab allocator over a physical memory
+int initializeSlabs(PhysicalMemory* pm) {
+    freeSlabs();
+    frame_slabs = calloc(pm->config.num_frames, sizeof(Slab*));
+    if (frame_slabs == NULL) return -1;
+
+    slab_pm = pm;
+    memset(partial, 0, sizeof(partial));
+    memset(&slabStats, 0, sizeof(slabStats));
+    return 0;
+}
+
+// Function to release every slab
+void freeSlabs(void) {
+    for (int sizeClass = 0; sizeClass <= MAX_CHUNKS_PER_PAGE; sizeClass++) {
+        while (partial[sizeClass]) {
+            Slab* slab = partial[sizeClass];
+            partialRemove(slab);
+            frame_slabs[slab->frame] = NULL;
+            free(slab);
+        }
+    }
+    // Full slabs are only reachable through the frame map
+    for (long long i = 0; frame_slabs && i < slab_pm->config.num_frames; i++) {
+        free(frame_slabs[i]);
+    }
+    free(frame_slabs);
+    frame_slabs = NULL;
+    slab_pm = NULL;
+}
+
+// Function to pick the size class of an allocation of `chunks` chunks
+int slabSizeClass(int chunks, const MemoryConfig* config) {
+    if (chunks <= 0 || 2 * chunks > config->chunks_per_page) return -1; // At least two objects must fit in a page
+    return chunks;
+}
+
+// Function to start a new slab of a size class: a fresh virtual page resident in a frame of its own
+static Slab* startSlab(int sizeClass, VirtualMemory* vm) {
+    Slab* slab = malloc(sizeof(Slab));
+    if (slab == NULL) return NULL;
+
+    slab->page_id = allocatePage(vm);
+    slab->frame = allocateFrameBlock(slab_pm, 0);
+    if (slab->frame == -1 && evictPage(slab_pm) != -1) {
+        slab->frame = allocateFrameBlock(slab_pm, 0); // Physical memory was full: the replacement policy made room
+    }
+    if (slab->page_id == -1 || slab->frame == -1) {
+        if (slab->page_id != -1) freeVirtualPage(slab->page_id, vm);
+        if (slab->frame != -1) freeFrameBlock(slab_pm, slab->frame, 0);
+        free(slab);
+        return NULL;
+    }
+
+    int objects = slab_pm->config.chunks_per_page / sizeClass;
+    slab->size_class = sizeClass;
+    slab->free_slots = (1u << objects) - 1;
+    slab->used = 0;
+    frame_slabs[slab->frame] = slab;
+    partialPush(slab);
+    slabStats.slabs[sizeClass]++;
+    slabStats.slab_pages++;
+    return slab;
+}
+
+// Function to allocate an object of `chunks` chunks from a shared slab page
+int slabAllocate(int chunks, VirtualMemory* vm, long long* pageID, int* frameID, unsigned int* chunkMask) {
+    if (slab_pm == NULL) return -1;
+    int sizeClass = slabSizeClass(chunks, &slab_pm->config);
+    if (sizeClass == -1) return -1;
+
+    Slab* slab = partial[sizeClass];
+    if (slab == NULL && (slab = startSlab(sizeClass, vm)) == NULL) return -1;
+
+    // Take the lowest free object; a slab with no free object left leaves the partial list
+    int slot = __builtin_ctz(slab->free_slots);
+    slab->free_slots &= ~(1u << slot);
+    slab->used++;
+    if (slab->free_slots == 0) partialRemove(slab);
+
+    unsigned int mask = ((1u << sizeClass) - 1) << (slot * sizeClass);
+    vm->allocated_chunks[slab->page_id] |= mask;
+    slab_pm->allocated_chunks[slab->frame] |= mask;
+    slabStats.objects[sizeClass]++;
+    slabStats.object_chunks += sizeClass;
+
+    *pageID = slab->page_id;
+    *frameID = slab->frame;
+    *chunkMask = mask;
+    return 0;
+}
+
+// Function to release an object of a slab, returning the slab's page and frame once it is empty
+void slabFree(int frameID, unsigned int chunkMask, VirtualMemory* vm) {
+    if (slab_pm == NULL || frameID < 0 || frameID >= slab_pm->config.num_frames || chunkMask == 0) return;
+    Slab* slab = frame_slabs[frameID];
+    if (slab == NULL) return;
+
+    int slot = __builtin_ctz(chunkMask) / slab->size_class;
+    if (slab->free_slots & (1u << slot)) return; // Already free
+
+    if (slab->free_slots == 0) partialPush(slab); // The slab was full
+    slab->free_slots |= 1u << slot;
+    slab->used--;
+    vm->allocated_chunks[slab->page_id] &= ~chunkMask;
+    slab_pm->allocated_chunks[slab->frame] &= ~chunkMask;
+    slabStats.objects[slab->size_class]--;
+    slabStats.object_chunks -= slab->size_class;
+
+    if (slab->used == 0) {
+        partialRemove(slab);
+        freeVirtualPage(slab->page_id, vm);
+        freeFrameBlock(slab_pm, slab->frame, 0);
+        frame_slabs[slab->frame] = NULL;
+        slabStats.slabs[slab->size_class]--;
+        slabStats.slab_pages--;
+        free(slab);
+    }
+}
+
+// Function to get the counters of the slab allocator
+const SlabStats* getSlabStats(void) {
+    return &slabStats;
+}
+
+// Function to get the size of the slab allocator's state in a state image
+size_t slabStateSize(void) {
+    return sizeof(SavedSlabs) + slabStats.slab_pages * sizeof(Slab);
+}
+
+// Function to write the slabs for a state image
+void saveSlabState(void* buffer) {
+    SavedSlabs* saved = buffer;
+    Slab* slabs = (Slab*)(saved + 1);
+    saved->stats = slabStats;
+    saved->count = 0;
+
+    for (int sizeClass = 0; sizeClass <= MAX_CHUNKS_PER_PAGE; sizeClass++) {
+        for (Slab* slab = partial[sizeClass]; slab != NULL; slab = slab->next) slabs[saved->count++] = *slab;
+    }
+    for (long long i = 0; frame_slabs && i < slab_pm->config.num_frames; i++) {
+        if (frame_slabs[i] != NULL && frame_slabs[i]->free_slots == 0) slabs[saved->count++] = *frame_slabs[i];
+    }
+    for (long long i = 0; i < saved->count; i++) slabs[i].prev = slabs[i].next = NULL;
+}
+
+// Function to restore the slabs from a state image
+int loadSlabState(const void* buffer, size_t size) {
+    const SavedSlabs* saved = buffer;
+    if (slab_pm == NULL || size < sizeof(SavedSlabs) || saved->count < 0
+        || size != sizeof(SavedSlabs) + saved->count * sizeof(Slab)) {
+        return -1;
+    }
+
+    // Slabs are pushed at the head of their partial list, so restore them last to first to keep the saved order
+    const Slab* slabs = (const Slab*)(saved + 1);
+    for (long long i = saved->count - 1; i >= 0; i--) {
+        if (slabs[i].frame < 0 || slabs[i].frame >= slab_pm->config.num_frames || frame_slabs[slabs[i].frame] != NULL
+            || slabSizeClass(slabs[i].size_class, &slab_pm->config) == -1) {
+            return -1;
+        }
+        Slab* slab = malloc(sizeof(Slab));
+        if (slab == NULL) return -1;
+        *slab = slabs[i];
+        frame_slabs[slab->frame] = slab;
+        if (slab->free_slots != 0) {
+            partialPush(slab);
+        } else {
+            slab->prev = slab->next = NULL;
+        }
+    }
+    slabStats = saved->stats;
+    return 0;
+}
@@ -0,0 +1,111 @@
+#include "page_table.h"
+
+#ifndef SLAB_H
+#define SLAB_H
+
+/**
+ * Define the Slab structure, a virtual page shared by the sub-page allocations of several processes.
+ * A slab of size class k is cut into chunks_per_page / k objects of k chunks each; object i covers chunks
+ * [i * k, (i + 1) * k) of the page. Slab pages stay resident in their frame for as long as they hold an object,
+ * and are not subject to page replacement, since every process with an object in the page maps the same frame.
+**/
+typedef struct Slab {
+    long long page_id;          // Virtual page cut into objects
+    int frame;                  // Frame the page is resident in
+    int size_class;             // Chunks per object
+    unsigned int free_slots;    // Bit i is set while object i is free
+    int used;                   // Number of objects in use
+    struct Slab* prev;          // Neighbours on the partial list of the size class, while the slab has a free object
+    struct Slab* next;
+} Slab;
+
+// Define the SlabStats structure, the counters of the slab allocator, per size class (index: chunks per object)
+typedef struct SlabStats {
+    long long slabs[MAX_CHUNKS_PER_PAGE + 1];   // Slab pages
+    long long objects[MAX_CHUNKS_PER_PAGE + 1]; // Objects in use
+    long long slab_pages;                       // Slab pages over all size classes
+    long long object_chunks;                    // Chunks held by objects in use over all size classes
+} SlabStats;
+
+/**
+ * initializeSlabs function sets up empty partial lists for every size class and the map from frames to slabs.
+ * The slabs take their frames from pm, which must outlive them, so page reservation needs no PhysicalMemory.
+ * Returns 0 on success, or -1 if the frame map cannot be allocated.
+
+   Parameters:
+   - pm: A pointer to the PhysicalMemory structure slab frames are allocated from.
+**/
+int initializeSlabs(PhysicalMemory* pm);
+
+/**
+ * freeSlabs function releases every slab and the frame map; it does not return their pages or frames.
+**/
+void freeSlabs(void);
+
+/**
+ * slabSizeClass function returns the size class serving an allocation of `chunks` chunks, or -1 if the allocation
+ * is better served by a page of its own: only allocations of at most half a page share pages.
+
+   Parameters:
+   - chunks: The number of chunks to allocate.
+   - config: The geometry of the memory system.
+**/
+int slabSizeClass(int chunks, const MemoryConfig* config);
+
+/**
+ * slabAllocate function allocates an object of `chunks` chunks from the first slab on the partial list of its size
+ * class, starting a new slab (a new virtual page and frame, evicting a page if physical memory is full) if the list
+ * is empty. The object's chunks are marked in use in the page's and the frame's chunk masks.
+ * Returns 0 and the object's page, frame and chunk mask, or -1 if the size class does not exist or no slab can be started.
+
+   Parameters:
+   - chunks: The number of chunks to allocate; see slabSizeClass.
+   - vm: A pointer to the VirtualMemory structure.
+   - pageID: Set to the virtual page holding the object.
+   - frameID: Set to the frame holding the object.
+   - chunkMask: Set to the chunks of the page the object covers.
+**/
+int slabAllocate(int chunks, VirtualMemory* vm, long long* pageID, int* frameID, unsigned int* chunkMask);
+
+/**
+ * slabFree function releases the object covering chunkMask in the slab resident in frameID. A slab that becomes
+ * empty returns its page and frame; a full slab that gets a free object goes back on its partial list.
+
+   Parameters:
+   - frameID: The frame of the slab.
+   - chunkMask: The chunk mask returned by slabAllocate.
+   - vm: A pointer to the VirtualMemory structure.
+**/
+void slabFree(int frameID, unsigned int chunkMask, VirtualMemory* vm);
+
+/**
+ * getSlabStats function returns the counters of the slab allocator.
+**/
+const SlabStats* getSlabStats(void);
+
+/**
+ * slabStateSize function returns the number of bytes saveSlabState writes.
+**/
+size_t slabStateSize(void);
+
+/**
+ * saveSlabState function writes every slab, in the order of the partial lists, and the counters to buffer, for a
+ * state image (see snapshot.h).
+
+   Parameters:
+   - buffer: slabStateSize() bytes, aligned to 8 bytes.
+**/
+void saveSlabState(void* buffer);
+
+/**
+ * loadSlabState function gives the slab allocator, freshly set up by initializeSlabs, the slabs written by
+ * saveSlabState. Returns 0 on success, or -1 if the state is malformed or a slab cannot be allocated, after which
+ * the allocator must be set up again.
+
+   Parameters:
+   - buffer: The saved state, aligned to 8 bytes.
+   - size: The number of bytes in buffer.
+**/
+int loadSlabState(const void* buffer, size_t size);
+
+#endif // SLAB_H
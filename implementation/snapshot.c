@@ -0,0 +1,445 @@
+#include <stdio.h>      // For printf and perror
+#include <stdlib.h>     // For dynamic memory allocation and qsort
+#include <string.h>     // For memcpy and memcmp
+#include <stdint.h>     // For fixed-width image fields
+#include <fcntl.h>      // For open
+#include <unistd.h>     // For ftruncate and close
+#include <sys/mman.h>   // For mmap
+#include <sys/stat.h>   // For fstat
+#include "snapshot.h"
+#include "process_table.h"
+#include "replacement.h"
+#include "slab.h"
+#include "swap.h"
+#include "shared_segment.h"
+
+
+// Global variables defined in main.c
+extern int page_faults;
+extern int page_evictions;
+extern int num_accesses;
+
+#define STATE_MAGIC "PGSTATE"   // Including the terminating null character: 8 bytes
+#define STATE_VERSION 1
+
+// Every part of an image starts at a multiple of this many bytes
+#define STATE_ALIGNMENT 64
+
+// Define the StateLayout structure, the sizes of the structures an image stores as they are in memory; an image
+// can only be loaded by a build of the program where they are the same
+typedef struct StateLayout {
+    uint32_t virtual_memory;
+    uint32_t physical_memory;
+    uint32_t process;
+    uint32_t master_page_table;
+    uint32_t page_directory;
+    uint32_t secondary_page_table;
+    uint32_t arena_block;
+    uint32_t process_table;
+    uint32_t process_slot;
+    uint32_t pointer;
+} StateLayout;
+
+// Define the StateHeader structure, the start of a state image. Offsets are from the start of the image.
+typedef struct StateHeader {
+    char magic[8];                  // STATE_MAGIC
+    uint32_t version;               // STATE_VERSION
+    StateLayout layout;
+    uint64_t image_size;            // Bytes in the image
+    uint64_t vm;                    // VirtualMemory, its arrays as offsets
+    uint64_t pm;                    // PhysicalMemory, its arrays as offsets
+    uint64_t process_table;         // ProcessTable, its arrays as offsets, and each slot's process as an offset
+    uint64_t replacement;           // Replacement engine state (see saveReplacementState)
+    uint64_t replacement_size;
+    uint64_t slabs;                 // Slab allocator state (see saveSlabState)
+    uint64_t slab_size;
+    int32_t page_faults;            // Statistics counters
+    int32_t page_evictions;
+    int32_t num_accesses;
+    HugePageStats huge_page_stats;
+    ForkStats fork_stats;
+    ReadaheadStats readahead_stats;
+} StateHeader;
+
+// Define the PlacedBlock structure, an arena block being saved and its offset in the image
+typedef struct PlacedBlock {
+    const ArenaBlock* block;
+    uint64_t offset;
+} PlacedBlock;
+
+// Image being written or loaded
+static char* image = NULL;
+static uint64_t image_size;
+
+// Arena blocks of every process being saved, by address
+static PlacedBlock* placed = NULL;
+static long long placed_count;
+
+
+// Function to get the layout of the structures an image stores as they are in memory
+static StateLayout currentLayout(void) {
+    return (StateLayout){
+        sizeof(VirtualMemory), sizeof(PhysicalMemory), sizeof(Process), sizeof(MasterPageTable),
+        sizeof(PageDirectory), sizeof(SecondaryPageTable), sizeof(ArenaBlock), sizeof(ProcessTable),
+        sizeof(ProcessSlot), sizeof(void*),
+    };
+}
+
+// Function to reserve bytes at the end of the image being laid out, returning their offset
+static uint64_t place(uint64_t* end, uint64_t bytes) {
+    uint64_t offset = (*end + STATE_ALIGNMENT - 1) & ~(uint64_t)(STATE_ALIGNMENT - 1);
+    *end = offset + bytes;
+    return offset;
+}
+
+// A pointer stored in an image holds an offset
+static inline void* asStored(uint64_t offset) {
+    return (void*)(uintptr_t)offset;
+}
+
+static int compareBlocks(const void* a, const void* b) {
+    const ArenaBlock* x = ((const PlacedBlock*)a)->block;
+    const ArenaBlock* y = ((const PlacedBlock*)b)->block;
+    return x < y ? -1 : x > y;
+}
+
+// Function to find the offset in the image of memory allocated from a process's arena, 0 if it is not
+static uint64_t arenaOffset(const void* pointer) {
+    const char* address = pointer;
+    long long low = 0, high = placed_count - 1;
+    while (low <= high) {
+        long long mid = (low + high) / 2;
+        const ArenaBlock* block = placed[mid].block;
+        if (address < (const char*)block) {
+            high = mid - 1;
+        } else if (address >= (const char*)block->data + block->used) {
+            low = mid + 1;
+        } else {
+            return placed[mid].offset + (uint64_t)(address - (const char*)block);
+        }
+    }
+    return 0;
+}
+
+// Function to store the pointers of a page directory and the directories below it in the image's copy of it
+static void saveDirectory(const PageDirectory* dir, int level) {
+    PageDirectory* copy = (PageDirectory*)(image + arenaOffset(dir));
+    for (int i = 0; i < ENTRIES_PER_TABLE; i++) {
+        if (dir->entries[i] == NULL) continue;
+        copy->entries[i] = asStored(arenaOffset(dir->entries[i]));
+        if (level > 1) saveDirectory(dir->entries[i], level - 1);
+    }
+    if (dir->huge_entries != NULL) copy->huge_entries = asStored(arenaOffset(dir->huge_entries));
+}
+
+// Function to store the pointers of a process, its MasterPageTable and its arena in the image's copies of them
+static void saveProcess(const Process* process) {
+    const MasterPageTable* mpt = process->mpt;
+    Process* copy = (Process*)(image + arenaOffset(process));
+    copy->mpt = asStored(arenaOffset(mpt));
+    copy->vm = NULL;        // The loaded VirtualMemory
+    copy->attachments = NULL;
+
+    MasterPageTable* mptCopy = (MasterPageTable*)(image + arenaOffset(mpt));
+    mptCopy->root = asStored(arenaOffset(mpt->root));
+    mptCopy->arena.blocks = asStored(arenaOffset(mpt->arena.blocks));
+    for (const ArenaBlock* block = mpt->arena.blocks; block != NULL; block = block->next) {
+        ArenaBlock* blockCopy = (ArenaBlock*)(image + arenaOffset(block));
+        blockCopy->next = block->next ? asStored(arenaOffset(block->next)) : NULL;
+        blockCopy->size = block->used; // Nothing more is carved from a mapped block
+        blockCopy->mapped = false;
+    }
+    saveDirectory(mpt->root, PAGE_TABLE_LEVELS - 1);
+}
+
+// Function to write the simulation to a state image
+int save_state(const char* path, const VirtualMemory* vm, const PhysicalMemory* pm) {
+    if (swapEnabled() || sharedSegmentBytes() > 0) {
+        printf("A state with a swap device or shared segments cannot be saved.\n");
+        return -1;
+    }
+    const ProcessTable* table = getProcessTable();
+    long long numFrames = pm->config.num_frames;
+
+    // Lay the image out: the memory structures and their arrays, the process table, every arena block, the
+    // replacement engine and the slabs
+    uint64_t end = sizeof(StateHeader);
+    uint64_t vmOffset = place(&end, sizeof(VirtualMemory));
+    uint64_t pagesOffset = place(&end, PAGE_BITMAP_WORDS(vm->capacity) * sizeof(uint64_t));
+    uint64_t pageChunksOffset = place(&end, vm->capacity * sizeof(uint8_t));
+    uint64_t freePagesOffset = place(&end, vm->capacity * sizeof(long long));
+    uint64_t pmOffset = place(&end, sizeof(PhysicalMemory));
+    uint64_t framesOffset = place(&end, pm->bitmap_words * sizeof(uint64_t));
+    uint64_t summaryOffset = place(&end, pm->summary_words * sizeof(uint64_t));
+    uint64_t frameChunksOffset = place(&end, numFrames * sizeof(uint8_t));
+    uint64_t refCountsOffset = place(&end, numFrames * sizeof(uint32_t));
+    uint64_t blockNextOffset = place(&end, numFrames * sizeof(int));
+    uint64_t blockPrevOffset = place(&end, numFrames * sizeof(int));
+    uint64_t blockOrderOffset = place(&end, numFrames * sizeof(int8_t));
+    uint64_t tableOffset = place(&end, sizeof(ProcessTable));
+    uint64_t slotsOffset = place(&end, table->slot_count * sizeof(ProcessSlot));
+    uint64_t bucketsOffset = place(&end, (table->bucket_mask + 1) * sizeof(int));
+
+    long long blocks = 0;
+    Process* process;
+    for (int cursor = 0; (process = nextProcess(&cursor)) != NULL; ) {
+        for (const ArenaBlock* block = process->mpt->arena.blocks; block != NULL; block = block->next) blocks++;
+    }
+    placed = malloc((blocks ? blocks : 1) * sizeof(PlacedBlock));
+    if (placed == NULL) {
+        printf("Insufficient memory to save the state.\n");
+        return -1;
+    }
+    placed_count = 0;
+    for (int cursor = 0; (process = nextProcess(&cursor)) != NULL; ) {
+        for (const ArenaBlock* block = process->mpt->arena.blocks; block != NULL; block = block->next) {
+            placed[placed_count++] = (PlacedBlock){ block, place(&end, sizeof(ArenaBlock) + block->used) };
+        }
+    }
+    qsort(placed, placed_count, sizeof(PlacedBlock), compareBlocks);
+
+    size_t replacementSize = replacementStateSize();
+    size_t slabSize = slabStateSize();
+    uint64_t replacementOffset = place(&end, replacementSize);
+    uint64_t slabOffset = place(&end, slabSize);
+    image_size = end;
+
+    // Write it through a shared mapping of the file
+    int fd = open(path, O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if (fd == -1 || ftruncate(fd, (off_t)image_size) != 0
+        || (image = mmap(NULL, image_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0)) == MAP_FAILED) {
+        perror(path);
+        if (fd != -1) close(fd);
+        image = NULL;
+        free(placed);
+        placed = NULL;
+        return -1;
+    }
+    close(fd);
+
+    StateHeader* header = (StateHeader*)image;
+    memcpy(header->magic, STATE_MAGIC, sizeof(header->magic));
+    header->version = STATE_VERSION;
+    header->layout = currentLayout();
+    header->image_size = image_size;
+    header->vm = vmOffset;
+    header->pm = pmOffset;
+    header->process_table = tableOffset;
+    header->replacement = replacementOffset;
+    header->replacement_size = replacementSize;
+    header->slabs = slabOffset;
+    header->slab_size = slabSize;
+    header->page_faults = page_faults;
+    header->page_evictions = page_evictions;
+    header->num_accesses = num_accesses;
+    header->huge_page_stats = *getHugePageStats();
+    header->fork_stats = *getForkStats();
+    header->readahead_stats = *getReadaheadStats();
+
+    VirtualMemory* vmCopy = (VirtualMemory*)(image + vmOffset);
+    *vmCopy = *vm;
+    vmCopy->allocated_pages = asStored(pagesOffset);
+    vmCopy->allocated_chunks = asStored(pageChunksOffset);
+    vmCopy->free_pages = asStored(freePagesOffset);
+    vmCopy->mapped = false;
+    memcpy(image + pagesOffset, vm->allocated_pages, PAGE_BITMAP_WORDS(vm->capacity) * sizeof(uint64_t));
+    memcpy(image + pageChunksOffset, vm->allocated_chunks, vm->capacity * sizeof(uint8_t));
+    memcpy(image + freePagesOffset, vm->free_pages, vm->free_count * sizeof(long long));
+
+    PhysicalMemory* pmCopy = (PhysicalMemory*)(image + pmOffset);
+    *pmCopy = *pm;
+    pmCopy->free_frames = asStored(framesOffset);
+    pmCopy->free_summary = asStored(summaryOffset);
+    pmCopy->allocated_chunks = asStored(frameChunksOffset);
+    pmCopy->ref_counts = asStored(refCountsOffset);
+    pmCopy->block_next = asStored(blockNextOffset);
+    pmCopy->block_prev = asStored(blockPrevOffset);
+    pmCopy->block_order = asStored(blockOrderOffset);
+    pmCopy->mapped = false;
+    memcpy(image + framesOffset, pm->free_frames, pm->bitmap_words * sizeof(uint64_t));
+    memcpy(image + summaryOffset, pm->free_summary, pm->summary_words * sizeof(uint64_t));
+    memcpy(image + frameChunksOffset, pm->allocated_chunks, numFrames * sizeof(uint8_t));
+    memcpy(image + refCountsOffset, pm->ref_counts, numFrames * sizeof(uint32_t));
+    memcpy(image + blockNextOffset, pm->block_next, numFrames * sizeof(int));
+    memcpy(image + blockPrevOffset, pm->block_prev, numFrames * sizeof(int));
+    memcpy(image + blockOrderOffset, pm->block_order, numFrames * sizeof(int8_t));
+
+    // Copy the arenas as they are, then turn the pointers in them into offsets
+    for (long long i = 0; i < placed_count; i++) {
+        memcpy(image + placed[i].offset, placed[i].block, sizeof(ArenaBlock) + placed[i].block->used);
+    }
+    for (int cursor = 0; (process = nextProcess(&cursor)) != NULL; ) saveProcess(process);
+
+    ProcessTable* tableCopy = (ProcessTable*)(image + tableOffset);
+    ProcessSlot* slotsCopy = (ProcessSlot*)(image + slotsOffset);
+    *tableCopy = *table;
+    tableCopy->slots = table->slots ? asStored(slotsOffset) : NULL;
+    tableCopy->slot_capacity = table->slot_count;
+    tableCopy->buckets = table->buckets ? asStored(bucketsOffset) : NULL;
+    for (int slot = 0; slot < table->slot_count; slot++) {
+        slotsCopy[slot] = table->slots[slot];
+        if (table->slots[slot].process != NULL) slotsCopy[slot].process = asStored(arenaOffset(table->slots[slot].process));
+    }
+    if (table->buckets) memcpy(image + bucketsOffset, table->buckets, (table->bucket_mask + 1) * sizeof(int));
+
+    saveReplacementState(image + replacementOffset);
+    saveSlabState(image + slabOffset);
+
+    munmap(image, image_size);
+    image = NULL;
+    free(placed);
+    placed = NULL;
+    return 0;
+}
+
+// Function to turn an offset stored in the loaded image into a pointer to bytes bytes, NULL if it is out of bounds
+static void* loadedPointer(const void* stored, uint64_t bytes) {
+    uint64_t offset = (uint64_t)(uintptr_t)stored;
+    if (offset < sizeof(StateHeader) || offset % sizeof(long long) != 0 || offset > image_size
+        || bytes > image_size - offset) {
+        return NULL;
+    }
+    return image + offset;
+}
+
+// Function to turn the offsets of a loaded page directory, and of the directories below it, into pointers
+static int loadDirectory(PageDirectory* dir, int level) {
+    for (int i = 0; i < ENTRIES_PER_TABLE; i++) {
+        if (dir->entries[i] == NULL) continue;
+        dir->entries[i] = loadedPointer(dir->entries[i], level > 1 ? sizeof(PageDirectory) : sizeof(SecondaryPageTable));
+        if (dir->entries[i] == NULL || (level > 1 && loadDirectory(dir->entries[i], level - 1) != 0)) return -1;
+    }
+    if (dir->huge_entries != NULL) {
+        dir->huge_entries = loadedPointer(dir->huge_entries, ENTRIES_PER_TABLE * sizeof(PageTableEntry));
+        if (dir->huge_entries == NULL) return -1;
+    }
+    return 0;
+}
+
+// Function to turn the offsets of a loaded process, its MasterPageTable and its arena into pointers
+static int loadProcess(Process* process, VirtualMemory* vm) {
+    if (process->attachments != NULL) return -1;
+    process->vm = vm;
+    MasterPageTable* mpt = process->mpt = loadedPointer(process->mpt, sizeof(MasterPageTable));
+    if (mpt == NULL || (mpt->root = loadedPointer(mpt->root, sizeof(PageDirectory))) == NULL) return -1;
+
+    // The image holds fewer blocks than it has room for block headers, which bounds a corrupt, cyclic list
+    uint64_t blocks = 0;
+    for (ArenaBlock** link = &mpt->arena.blocks; *link != NULL; link = &(*link)->next) {
+        ArenaBlock* block = loadedPointer(*link, sizeof(ArenaBlock));
+        if (block == NULL || block->size != block->used || loadedPointer(*link, sizeof(ArenaBlock) + block->used) == NULL
+            || ++blocks > image_size / sizeof(ArenaBlock)) {
+            return -1;
+        }
+        block->mapped = true;
+        *link = block;
+    }
+    return loadDirectory(mpt->root, PAGE_TABLE_LEVELS - 1);
+}
+
+// Function to map a state image and resume the simulation it holds
+int load_state(const char* path, VirtualMemory** vmOut, PhysicalMemory** pmOut) {
+    if (countProcesses() != 0 || image != NULL) {
+        printf("A state can only be loaded before any process is created.\n");
+        return -1;
+    }
+
+    int fd = open(path, O_RDONLY);
+    struct stat st;
+    if (fd == -1 || fstat(fd, &st) != 0) {
+        perror(path);
+        if (fd != -1) close(fd);
+        return -1;
+    }
+    image_size = st.st_size;
+    if (image_size < sizeof(StateHeader)) {
+        printf("%s is not a state image.\n", path);
+        close(fd);
+        return -1;
+    }
+    image = mmap(NULL, image_size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (image == MAP_FAILED) {
+        perror(path);
+        image = NULL;
+        return -1;
+    }
+
+    const StateHeader* header = (const StateHeader*)image;
+    StateLayout layout = currentLayout();
+    if (memcmp(header->magic, STATE_MAGIC, sizeof(header->magic)) != 0 || header->version != STATE_VERSION
+        || memcmp(&header->layout, &layout, sizeof(layout)) != 0 || header->image_size != image_size) {
+        printf("%s is not a state image saved by this build of the program.\n", path);
+        munmap(image, image_size);
+        image = NULL;
+        return -1;
+    }
+
+    // The memory structures are copied to the heap, as they are freed with the rest of the simulation; their arrays
+    // stay in the image
+    VirtualMemory* vm = malloc(sizeof(VirtualMemory));
+    PhysicalMemory* pm = malloc(sizeof(PhysicalMemory));
+    const VirtualMemory* vmSaved = loadedPointer(asStored(header->vm), sizeof(VirtualMemory));
+    const PhysicalMemory* pmSaved = loadedPointer(asStored(header->pm), sizeof(PhysicalMemory));
+    const ProcessTable* tableSaved = loadedPointer(asStored(header->process_table), sizeof(ProcessTable));
+    if (vm == NULL || pm == NULL || vmSaved == NULL || pmSaved == NULL || tableSaved == NULL) goto fail;
+    *vm = *vmSaved;
+    *pm = *pmSaved;
+    long long numFrames = pm->config.num_frames;
+    vm->mapped = pm->mapped = true;
+    vm->allocated_pages = loadedPointer(vm->allocated_pages, PAGE_BITMAP_WORDS(vm->capacity) * sizeof(uint64_t));
+    vm->allocated_chunks = loadedPointer(vm->allocated_chunks, vm->capacity * sizeof(uint8_t));
+    vm->free_pages = loadedPointer(vm->free_pages, vm->capacity * sizeof(long long));
+    pm->free_frames = loadedPointer(pm->free_frames, pm->bitmap_words * sizeof(uint64_t));
+    pm->free_summary = loadedPointer(pm->free_summary, pm->summary_words * sizeof(uint64_t));
+    pm->allocated_chunks = loadedPointer(pm->allocated_chunks, numFrames * sizeof(uint8_t));
+    pm->ref_counts = loadedPointer(pm->ref_counts, numFrames * sizeof(uint32_t));
+    pm->block_next = loadedPointer(pm->block_next, numFrames * sizeof(int));
+    pm->block_prev = loadedPointer(pm->block_prev, numFrames * sizeof(int));
+    pm->block_order = loadedPointer(pm->block_order, numFrames * sizeof(int8_t));
+    if (!vm->allocated_pages || !vm->allocated_chunks || !vm->free_pages || !pm->free_frames || !pm->free_summary
+        || !pm->allocated_chunks || !pm->ref_counts || !pm->block_next || !pm->block_prev || !pm->block_order
+        || vm->capacity > vm->config.num_pages || numFrames != vm->config.num_frames) {
+        goto fail;
+    }
+
+    // Turn the offsets of the processes into pointers, then register them in their saved slots
+    ProcessTable table = *tableSaved;
+    if (table.slot_count < 0 || (table.slot_count > 0 && table.buckets == NULL)) goto fail;
+    if (table.buckets != NULL) {
+        table.slots = table.slot_count ? loadedPointer(table.slots, table.slot_count * sizeof(ProcessSlot)) : NULL;
+        table.buckets = loadedPointer(table.buckets, (table.bucket_mask + 1) * sizeof(int));
+        if ((table.slot_count && table.slots == NULL) || table.buckets == NULL) goto fail;
+    }
+    for (int slot = 0; slot < table.slot_count; slot++) {
+        if (table.slots[slot].process == NULL) continue;
+        table.slots[slot].process = loadedPointer(table.slots[slot].process, sizeof(Process));
+        if (table.slots[slot].process == NULL || loadProcess(table.slots[slot].process, vm) != 0) goto fail;
+    }
+    const void* replacement = loadedPointer(asStored(header->replacement), header->replacement_size);
+    const void* slabs = loadedPointer(asStored(header->slabs), header->slab_size);
+    if (replacement == NULL || slabs == NULL || restoreProcessTable(&table) != 0
+        || loadReplacementState(replacement, header->replacement_size) != 0
+        || initializeSlabs(pm) != 0 || loadSlabState(slabs, header->slab_size) != 0) {
+        goto fail;
+    }
+
+    page_faults = header->page_faults;
+    page_evictions = header->page_evictions;
+    num_accesses = header->num_accesses;
+    restorePagingStats(&header->huge_page_stats, &header->fork_stats, &header->readahead_stats);
+    *vmOut = vm;
+    *pmOut = pm;
+    return 0; // The image stays mapped: the simulation lives in it
+
+fail:
+    printf("%s is not a valid state image, or memory ran out while loading it.\n", path);
+    freeProcessTable();
+    freeReplacement();
+    freeSlabs();
+    free(vm);
+    free(pm);
+    munmap(image, image_size);
+    image = NULL;
+    return -1;
+}
@@ -0,0 +1,49 @@
+#include "page_table.h"
+
+#ifndef SNAPSHOT_H
+#define SNAPSHOT_H
+
+/**
+ * A state image is a single file holding a whole simulation: the VirtualMemory and PhysicalMemory structures with
+ * their metadata arrays, every process's arena (the Process, its MasterPageTable and its page table tree), the
+ * process table, the replacement engine's reverse map and per-frame state, and the slab allocator's slabs.
+ *
+ * Everything is stored in the layout it has in memory, so an image is position independent only through its
+ * pointers: each pointer inside the image holds the offset of what it points to from the start of the file
+ * (0 for NULL). Loading maps the file copy-on-write and turns the offsets back into pointers, which only touches the
+ * processes and their page directories; the metadata arrays and the SecondaryPageTables, the bulk of a large simulation, are read by
+ * the kernel as they are first used. Memory in the image is never freed: the arrays move to the heap the first time
+ * they grow, arenas add heap blocks after their mapped ones, and the image stays mapped until the program exits.
+ *
+ * The statistics counters carry on from the saved ones, except the TLB's: the TLB starts out empty. A swap device
+ * and shared segments are not part of an image, so a state using either cannot be saved.
+**/
+
+/**
+ * save_state function writes the simulation to a state image at path, replacing any file there.
+ * Returns 0 on success, or -1 (with a message) if the state uses a swap device or shared segments, or if the file
+ * cannot be written.
+
+   Parameters:
+   - path: The path of the image.
+   - vm: A pointer to the VirtualMemory structure.
+   - pm: A pointer to the PhysicalMemory structure.
+**/
+int save_state(const char* path, const VirtualMemory* vm, const PhysicalMemory* pm);
+
+/**
+ * load_state function maps the state image at path and resumes the simulation it holds: it returns the image's
+ * virtual and physical memory, and restores the process table, the replacement engine (with the policy the state
+ * was saved with) and the slab allocator. It must be called before any process is created, and the TLB and the
+ * shared segment registry set up afterwards, over the new physical memory.
+ * Returns 0 on success, or -1 (with a message) if the file is not a state image saved by this build of the
+ * program, or memory runs out; the process table, the replacement engine and the slab allocator are then empty.
+
+   Parameters:
+   - path: The path of the image.
+   - vm: Set to the loaded VirtualMemory structure.
+   - pm: Set to the loaded PhysicalMemory structure.
+**/
+int load_state(const char* path, VirtualMemory** vm, PhysicalMemory** pm);
+
+#endif // SNAPSHOT_H
@@ -0,0 +1,329 @@
+#define _GNU_SOURCE     // For pwritev
+#include <stdio.h>      // For printf and perror
+#include <stdlib.h>     // For dynamic memory allocation
+#include <string.h>     // For memset and memcpy
+#include <stdint.h>     // For fixed-width slot headers
+#include <fcntl.h>      // For open
+#include <unistd.h>     // For pread, ftruncate and close
+#include <sys/uio.h>    // For pwritev
+#include <limits.h>     // For IOV_MAX
+#include <pthread.h>    // For the writeback thread
+#include "swap.h"
+
+
+#define SWAP_SLOT_MAGIC 0x50475357u // "PGSW"
+
+// Define the SlotHeader structure, written at the start of every slot to check it is read back intact
+typedef struct SlotHeader {
+    uint32_t magic;     // SWAP_SLOT_MAGIC
+    int32_t slot;       // Slot the page was written to
+    uint64_t sequence;  // Number of the write, counting every write to the device
+} SlotHeader;
+
+// Swap device, set up by initializeSwap; fd is -1 while there is none
+static int fd = -1;
+static int page_size;
+static int num_slots;
+
+// Slot allocator, used by the paging engine only: slots below next_slot that are free are on the free stack
+static uint32_t* slot_refs = NULL;  // Number of virtual pages whose contents each slot holds
+static int* free_slots = NULL;
+static int free_count;
+static int next_slot;
+
+// Slot of each virtual page, -1 for none, grown on demand. Keyed by page ID, not kept in PageTableEntries, because a
+// shared segment page is mapped by several processes' entries (see swap.h)
+static int* page_slots = NULL;
+static long long page_capacity;
+
+// Writeback queue: pages [queue_head, queue_tail) wait for the writeback thread, in queue_pages
+// at index % SWAP_WRITEBACK_QUEUE. Everything below is guarded by lock.
+static pthread_mutex_t lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t queued = PTHREAD_COND_INITIALIZER;   // A page was queued, or the thread must stop
+static pthread_cond_t written = PTHREAD_COND_INITIALIZER;  // A batch was written
+static char* queue_pages = NULL;
+static int queue_slots[SWAP_WRITEBACK_QUEUE];
+static long long queue_head, queue_tail;
+static uint8_t* slot_pending = NULL;   // Number of queued writes to each slot
+static uint64_t sequence;
+static bool stopping;
+static pthread_t writeback_thread;
+static SwapStats swapStats;
+static SwapStats snapshot;
+
+
+// Writeback thread: write queued pages in batches until stopped, one pwritev per run of consecutive slots
+static void* writebackMain(void* arg) {
+    (void)arg;
+    struct iovec iov[SWAP_WRITEBACK_QUEUE];
+    pthread_mutex_lock(&lock);
+    while (1) {
+        while (queue_head == queue_tail && !stopping) pthread_cond_wait(&queued, &lock);
+        if (queue_head == queue_tail) break; // Stopping, and everything is written
+
+        // The pages below end stay put while the lock is released: new pages are only queued at or after end
+        long long start = queue_head, end = queue_tail;
+        pthread_mutex_unlock(&lock);
+
+        long long calls = 0, pagesWritten = 0;
+        for (long long i = start; i < end; ) {
+            int first = queue_slots[i % SWAP_WRITEBACK_QUEUE];
+            int count = 0;
+            do {
+                iov[count].iov_base = queue_pages + (i % SWAP_WRITEBACK_QUEUE) * (size_t)page_size;
+                iov[count].iov_len = page_size;
+                count++;
+                i++;
+            } while (i < end && count < IOV_MAX && queue_slots[i % SWAP_WRITEBACK_QUEUE] == first + count);
+
+            if (pwritev(fd, iov, count, (off_t)first * page_size) == (ssize_t)count * page_size) {
+                pagesWritten += count;
+            } else {
+                perror("swap writeback");
+            }
+            calls++;
+        }
+
+        pthread_mutex_lock(&lock);
+        for (long long i = start; i < end; i++) slot_pending[queue_slots[i % SWAP_WRITEBACK_QUEUE]]--;
+        queue_head = end;
+        swapStats.writeback_batches++;
+        swapStats.writeback_calls += calls;
+        swapStats.swap_outs += pagesWritten;
+        swapStats.bytes_out += pagesWritten * page_size;
+        pthread_cond_broadcast(&written);
+    }
+    pthread_mutex_unlock(&lock);
+    return NULL;
+}
+
+// Function to set up the swap device and start the writeback thread
+int initializeSwap(const char* path, long long size, const MemoryConfig* config) {
+    if (fd != -1) return -1;
+
+    page_size = config->page_size;
+    long long slots = size >> config->page_shift;
+    if (slots <= 0 || slots > INT32_MAX) {
+        printf("The swap device must hold between 1 and %d pages.\n", INT32_MAX);
+        return -1;
+    }
+    num_slots = (int)slots;
+
+    fd = open(path, O_RDWR | O_CREAT | O_TRUNC, 0600);
+    if (fd == -1) {
+        perror(path);
+        return -1;
+    }
+    if (ftruncate(fd, (off_t)num_slots * page_size) != 0) {
+        perror(path);
+        freeSwap();
+        return -1;
+    }
+
+    slot_refs = calloc(num_slots, sizeof(uint32_t));
+    free_slots = malloc(num_slots * sizeof(int));
+    slot_pending = calloc(num_slots, sizeof(uint8_t));
+    queue_pages = calloc(SWAP_WRITEBACK_QUEUE, page_size);
+    if (!slot_refs || !free_slots || !slot_pending || !queue_pages) {
+        printf("Failed to allocate the swap device.\n");
+        freeSwap();
+        return -1;
+    }
+    free_count = 0;
+    next_slot = 0;
+    queue_head = queue_tail = 0;
+    sequence = 0;
+    stopping = false;
+    swapStats = (SwapStats){ .slots = num_slots };
+
+    if (pthread_create(&writeback_thread, NULL, writebackMain, NULL) != 0) {
+        printf("Failed to start the swap writeback thread.\n");
+        free(queue_pages);
+        queue_pages = NULL; // Tells freeSwap there is no thread to stop
+        freeSwap();
+        return -1;
+    }
+    return 0;
+}
+
+// Function to flush the writeback queue, stop the writeback thread and close the swap device
+void freeSwap(void) {
+    if (fd == -1) return;
+
+    if (queue_pages != NULL) {
+        pthread_mutex_lock(&lock);
+        stopping = true;
+        pthread_cond_signal(&queued);
+        pthread_mutex_unlock(&lock);
+        pthread_join(writeback_thread, NULL);
+    }
+
+    close(fd);
+    fd = -1;
+    free(slot_refs);
+    free(free_slots);
+    free(slot_pending);
+    free(queue_pages);
+    free(page_slots);
+    slot_refs = NULL;
+    free_slots = NULL;
+    slot_pending = NULL;
+    queue_pages = NULL;
+    page_slots = NULL;
+    page_capacity = 0;
+}
+
+bool swapEnabled(void) {
+    return fd != -1;
+}
+
+// Function to take a free slot, -1 if the device is full
+static int allocateSlot(void) {
+    if (free_count > 0) return free_slots[--free_count];
+    if (next_slot < num_slots) return next_slot++;
+    return -1;
+}
+
+// Function to drop a reference to a slot, freeing it with the last one. A write still queued to the slot is
+// harmless: a later write to the slot is queued after it, and reads wait for both.
+static void releaseSlot(int slot) {
+    if (--slot_refs[slot] == 0) {
+        free_slots[free_count++] = slot;
+        swapStats.slots_in_use--;
+    }
+}
+
+// Function to queue a page for writeback to a slot, waiting for room in the queue
+static void queueWrite(int slot) {
+    pthread_mutex_lock(&lock);
+    while (queue_tail - queue_head == SWAP_WRITEBACK_QUEUE) {
+        swapStats.stalls++;
+        pthread_cond_wait(&written, &lock);
+    }
+    char* page = queue_pages + (queue_tail % SWAP_WRITEBACK_QUEUE) * (size_t)page_size;
+    SlotHeader header = { SWAP_SLOT_MAGIC, slot, ++sequence };
+    memcpy(page, &header, sizeof(header));
+    queue_slots[queue_tail % SWAP_WRITEBACK_QUEUE] = slot;
+    slot_pending[slot]++;
+    queue_tail++;
+    pthread_cond_signal(&queued);
+    pthread_mutex_unlock(&lock);
+}
+
+int swapSlotOf(long long pageID) {
+    if (pageID < 0 || pageID >= page_capacity) return -1;
+    return page_slots[pageID];
+}
+
+void swapSetPageSlot(long long pageID, int slot) {
+    if (fd == -1 || pageID < 0) return;
+    if (pageID >= page_capacity) {
+        if (slot == -1) return;
+        long long capacity = page_capacity ? page_capacity : 1024;
+        while (capacity <= pageID) capacity *= 2;
+        int* slots = realloc(page_slots, capacity * sizeof(int));
+        if (slots == NULL) return; // The page is faulted back in as a new page
+        for (long long i = page_capacity; i < capacity; i++) slots[i] = -1;
+        page_slots = slots;
+        page_capacity = capacity;
+    }
+
+    int old = page_slots[pageID];
+    if (old == slot) return;
+    if (slot != -1) slot_refs[slot]++;
+    if (old != -1) releaseSlot(old);
+    page_slots[pageID] = slot;
+}
+
+void swapForgetPage(long long pageID) {
+    if (swapSlotOf(pageID) != -1) swapSetPageSlot(pageID, -1);
+}
+
+// Function to take a slot to write a page to: the page's own slot if no other page uses it, otherwise a new one
+static int slotForWrite(int slot) {
+    if (slot != -1 && slot_refs[slot] == 1) return slot;
+
+    int newSlot = allocateSlot();
+    if (newSlot != -1) swapStats.slots_in_use++;
+    return newSlot;
+}
+
+int swapOut(int slot, bool dirty) {
+    if (fd == -1) return -1;
+    if (!dirty) {
+        swapStats.clean_evictions++; // The slot, if any, still holds the page
+        return slot;
+    }
+
+    int target = slotForWrite(slot);
+    if (target == -1) {
+        swapStats.dropped++;
+        return -1;
+    }
+    swapStats.dirty_evictions++;
+    queueWrite(target);
+    return target;
+}
+
+int swapClean(long long pageID) {
+    if (fd == -1) return -1;
+
+    int slot = slotForWrite(swapSlotOf(pageID));
+    if (slot == -1) return -1;
+    queueWrite(slot);
+    if (slot != swapSlotOf(pageID)) {
+        swapSetPageSlot(pageID, slot);
+        if (swapSlotOf(pageID) != slot) { // The slot map could not grow: give the slot back
+            slot_refs[slot] = 1;
+            releaseSlot(slot);
+            return -1;
+        }
+    }
+    swapStats.cleaned_ahead++;
+    return 0;
+}
+
+int swapIn(long long pageID) {
+    int slot = swapSlotOf(pageID);
+    if (fd == -1 || slot == -1) return 0;
+
+    // The slot's latest contents may still be in the writeback queue
+    pthread_mutex_lock(&lock);
+    if (slot_pending[slot] > 0) {
+        swapStats.stalls++;
+        while (slot_pending[slot] > 0) pthread_cond_wait(&written, &lock);
+    }
+    pthread_mutex_unlock(&lock);
+
+    char* page = malloc(page_size);
+    if (page == NULL) return -1;
+    ssize_t bytes = pread(fd, page, page_size, (off_t)slot * page_size);
+    SlotHeader header;
+    memcpy(&header, page, sizeof(header));
+    free(page);
+
+    pthread_mutex_lock(&lock);
+    if (bytes != page_size || header.magic != SWAP_SLOT_MAGIC || header.slot != slot) {
+        swapStats.read_errors++;
+        pthread_mutex_unlock(&lock);
+        return -1;
+    }
+    swapStats.swap_ins++;
+    swapStats.bytes_in += page_size;
+    pthread_mutex_unlock(&lock);
+    return 1;
+}
+
+bool swapWritebackIdle(void) {
+    pthread_mutex_lock(&lock);
+    bool idle = queue_head == queue_tail;
+    pthread_mutex_unlock(&lock);
+    return idle;
+}
+
+const SwapStats* getSwapStats(void) {
+    pthread_mutex_lock(&lock);
+    snapshot = swapStats;
+    pthread_mutex_unlock(&lock);
+    return &snapshot;
+}
@@ -0,0 +1,143 @@
+#include <stdbool.h> // For bool type
+#include "page_table.h"
+
+#ifndef SWAP_H
+#define SWAP_H
+
+// default size of the swap device: 64MB
+#define DEFAULT_SWAP_SIZE (64LL * MB)
+
+// Dirty pages the writeback thread can be behind by; evicting another dirty page waits for it to catch up
+#define SWAP_WRITEBACK_QUEUE 64
+
+// The cleaner writes dirty pages out ahead of demand while fewer than 1/SWAP_CLEAN_WATERMARK of the frames are free
+// and the writeback thread is idle, looking at SWAP_CLEAN_SCAN frames and cleaning SWAP_CLEAN_BATCH pages at most
+// per page fault
+#define SWAP_CLEAN_WATERMARK 32
+#define SWAP_CLEAN_SCAN 32
+#define SWAP_CLEAN_BATCH 4
+
+/**
+ * The swap device is a file of page-sized slots. A page evicted with the dirty bit set is written to a slot, and its
+ * PageTableEntry is marked PTE_SWAPPED until it is faulted back in, which reads the slot. The slot of each virtual
+ * page is kept by virtual page ID rather than in the PageTableEntry: a shared segment page is mapped by the entries
+ * of every attached process, including ones that never faulted it in or have unmapped it, so its slot cannot live
+ * in any one of them; and the frame field of an entry that is not present always holds PTE_NO_FRAME, which pteFrame
+ * relies on. Forked pages that shared a swapped-out frame hold references to the same slot, which is freed when the
+ * last page using it goes away; a segment page's slot is only given up with the segment.
+ *
+ * A page read back keeps its slot, so evicting it again before it is written costs nothing; a page that was never
+ * written has nothing to save either and is faulted back in as a new page. Dirty pages are written by a writeback
+ * thread in batches, consecutive slots with a single pwritev, while the page fault that evicted them goes on.
+ * Frames hold no data in this simulator, so each slot is written with a header naming the slot, which is checked
+ * when the slot is read back.
+**/
+
+// Define the SwapStats structure, the counters of the swap device
+typedef struct SwapStats {
+    long long swap_ins;             // Pages read from the swap device
+    long long swap_outs;            // Pages written to the swap device
+    long long bytes_in;             // Bytes read
+    long long bytes_out;            // Bytes written
+    long long clean_evictions;      // Evicted pages that were not written since they were last saved (or created)
+    long long dirty_evictions;      // Evicted pages queued for writeback
+    long long cleaned_ahead;        // Dirty pages written by the cleaner before they were evicted
+    long long dropped;              // Dirty pages evicted while the swap device was full: their contents are lost
+    long long writeback_batches;    // Batches written by the writeback thread
+    long long writeback_calls;      // pwritev calls made by the writeback thread
+    long long stalls;               // Waits for the writeback thread: a full queue, or a read of a slot not written yet
+    long long read_errors;          // Slots that could not be read or did not hold what was written to them
+    long long slots;                // Slots in the swap device
+    long long slots_in_use;         // Slots holding a page
+} SwapStats;
+
+/**
+ * initializeSwap function creates (or truncates) the swap file at path with room for size bytes of pages and starts
+ * the writeback thread. Until it is called, or if it fails, evicted pages are simply dropped.
+ * Returns 0 on success, or -1 (with a message) if the file or the thread cannot be set up.
+
+   Parameters:
+   - path: The path of the swap file.
+   - size: The size of the swap device in bytes, rounded down to whole pages.
+   - config: The geometry of the memory system.
+**/
+int initializeSwap(const char* path, long long size, const MemoryConfig* config);
+
+/**
+ * freeSwap function waits for the writeback thread to write every queued page, stops it and closes the swap file.
+**/
+void freeSwap(void);
+
+/**
+ * swapEnabled function returns whether a swap device is in use.
+**/
+bool swapEnabled(void);
+
+/**
+ * swapSlotOf function returns the slot holding the contents of a virtual page, or -1 if the page has none.
+
+   Parameters:
+   - pageID: The ID of the page in virtual memory.
+**/
+int swapSlotOf(long long pageID);
+
+/**
+ * swapSetPageSlot function makes a slot hold the contents of a virtual page, taking a reference to the slot and
+ * dropping the page's reference to its previous slot. A slot of -1 leaves the page without one.
+
+   Parameters:
+   - pageID: The ID of the page in virtual memory.
+   - slot: The slot, as returned by swapOut or swapSlotOf.
+**/
+void swapSetPageSlot(long long pageID, int slot);
+
+/**
+ * swapForgetPage function drops the slot of a virtual page whose contents are no longer needed, as when the page is
+ * freed or its frame is deallocated.
+
+   Parameters:
+   - pageID: The ID of the page in virtual memory.
+**/
+void swapForgetPage(long long pageID);
+
+/**
+ * swapOut function saves the contents of a frame being evicted. A dirty frame is queued for writeback, to the slot
+ * it was read from if no other page uses that slot, otherwise to a new slot; a clean frame is already in slot, or
+ * was never written. Returns the slot holding the contents, which every page mapping the frame should be given with
+ * swapSetPageSlot, or -1 if the pages have nothing to read back.
+
+   Parameters:
+   - slot: The slot of one of the pages mapping the frame, -1 if none has one.
+   - dirty: Whether any page mapping the frame was written since it was last saved.
+**/
+int swapOut(int slot, bool dirty);
+
+/**
+ * swapClean function queues the contents of a resident page for writeback, so it can later be evicted without a
+ * write. Returns 0 on success, after which the caller clears the page's dirty bit, or -1 if no slot is free.
+
+   Parameters:
+   - pageID: The ID of the page in virtual memory.
+**/
+int swapClean(long long pageID);
+
+/**
+ * swapIn function reads the slot of a virtual page being faulted in, waiting for its writeback if it is still queued.
+ * Returns 1 if the page was read, 0 if it has no slot (it is a new page), or -1 if the slot could not be read.
+
+   Parameters:
+   - pageID: The ID of the page in virtual memory.
+**/
+int swapIn(long long pageID);
+
+/**
+ * swapWritebackIdle function returns whether the writeback thread has nothing queued.
+**/
+bool swapWritebackIdle(void);
+
+/**
+ * getSwapStats function returns a snapshot of the swap device's counters.
+**/
+const SwapStats* getSwapStats(void);
+
+#endif // SWAP_H
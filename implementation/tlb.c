@@ -0,0 +1,177 @@
+#include <stdlib.h> // For dynamic memory allocation
+#include "tlb.h"
+
+
+static TLB tlb = { .current_pid = -1 };
+
+// Function to pick the set a translation lives in
+static inline int tlbSetIndex(int pid, long long vpn) {
+    unsigned int key = (unsigned int)vpn ^ (unsigned int)(vpn >> 32);
+    if (tlb.asid_tagged) {
+        key ^= (unsigned int)pid * 2654435761u; // Spread processes over the sets
+    }
+    return key & (tlb.num_sets - 1);
+}
+
+// Function to initialize the TLB
+int initializeTLB(int numEntries, int ways, bool asidTagged) {
+    if (numEntries <= 0 || ways <= 0 || ways > numEntries) return -1;
+
+    int numSets = 1;
+    while (numSets * 2 <= numEntries / ways) numSets *= 2; // Round the set count down to a power of two
+
+    freeTLB();
+    tlb.entries = calloc((size_t)numSets * ways, sizeof(TLBEntry));
+    tlb.next_victim = calloc(numSets, sizeof(int));
+    if (!tlb.entries || !tlb.next_victim) {
+        freeTLB();
+        return -1;
+    }
+
+    tlb.num_sets = numSets;
+    tlb.ways = ways;
+    tlb.asid_tagged = asidTagged;
+    tlb.current_pid = -1;
+    tlb.huge_entries = 0;
+    tlb.hits = tlb.misses = tlb.flushes = 0;
+    return 0;
+}
+
+// Function to free the TLB
+void freeTLB(void) {
+    free(tlb.entries);
+    free(tlb.next_victim);
+    tlb.entries = NULL;
+    tlb.next_victim = NULL;
+    tlb.num_sets = 0;
+    tlb.ways = 0;
+    tlb.huge_entries = 0;
+}
+
+// Function to drop a single entry, keeping the count of huge-page entries
+static inline void tlbDropEntry(TLBEntry* entry) {
+    if (entry->is_valid && entry->is_huge) tlb.huge_entries--;
+    entry->is_valid = false;
+}
+
+// Function to look up a translation in the TLB
+int tlbLookup(int pid, long long vpn, int* prot) {
+    if (tlb.num_sets == 0) return -1;
+
+    // An untagged TLB only holds one address space, so a process switch flushes it
+    if (!tlb.asid_tagged && pid != tlb.current_pid) {
+        if (tlb.current_pid != -1) {
+            tlbFlush();
+            tlb.flushes++;
+        }
+        tlb.current_pid = pid;
+    }
+
+    TLBEntry* set = &tlb.entries[tlbSetIndex(pid, vpn) * tlb.ways];
+    for (int way = 0; way < tlb.ways; way++) {
+        if (set[way].is_valid && set[way].vpn == vpn && set[way].pid == pid && !set[way].is_huge) {
+            tlb.hits++;
+            if (prot) *prot = set[way].prot;
+            return set[way].frame_num;
+        }
+    }
+
+    // Huge pages are cached under their huge page number, in the set that number hashes to
+    if (tlb.huge_entries > 0) {
+        long long hugeVpn = vpn >> HUGE_PAGE_ORDER;
+        set = &tlb.entries[tlbSetIndex(pid, hugeVpn) * tlb.ways];
+        for (int way = 0; way < tlb.ways; way++) {
+            if (set[way].is_valid && set[way].vpn == hugeVpn && set[way].pid == pid && set[way].is_huge) {
+                tlb.hits++;
+                if (prot) *prot = set[way].prot;
+                return set[way].frame_num + (int)(vpn & ((1 << HUGE_PAGE_ORDER) - 1));
+            }
+        }
+    }
+    tlb.misses++;
+    return -1;
+}
+
+// Function to cache a page (or, with isHuge, a huge page numbered vpn) in the TLB
+static void tlbFill(int pid, long long vpn, int frameNum, int prot, bool isHuge) {
+    if (tlb.num_sets == 0) return;
+
+    int setIndex = tlbSetIndex(pid, vpn);
+    TLBEntry* set = &tlb.entries[setIndex * tlb.ways];
+
+    // Reuse an entry already holding this page, else a free entry, else the round-robin victim
+    int victim = -1;
+    for (int way = 0; way < tlb.ways; way++) {
+        if (set[way].is_valid && set[way].vpn == vpn && set[way].pid == pid && set[way].is_huge == isHuge) {
+            victim = way;
+            break;
+        }
+        if (!set[way].is_valid && victim == -1) victim = way;
+    }
+    if (victim == -1) {
+        victim = tlb.next_victim[setIndex];
+        tlb.next_victim[setIndex] = (victim + 1) % tlb.ways;
+    }
+
+    tlbDropEntry(&set[victim]);
+    set[victim].pid = pid;
+    set[victim].vpn = vpn;
+    set[victim].frame_num = frameNum;
+    set[victim].is_valid = true;
+    set[victim].is_huge = isHuge;
+    set[victim].prot = (unsigned char)prot;
+    if (isHuge) tlb.huge_entries++;
+}
+
+// Function to cache a translation in the TLB
+void tlbInsert(int pid, long long vpn, int frameNum, int prot) {
+    tlbFill(pid, vpn, frameNum, prot, false);
+}
+
+// Function to cache the translation of a whole huge page in the TLB
+void tlbInsertHuge(int pid, long long vpn, int firstFrame, int prot) {
+    tlbFill(pid, vpn >> HUGE_PAGE_ORDER, firstFrame, prot, true);
+}
+
+// Function to drop a single translation from the TLB
+void tlbInvalidatePage(int pid, long long vpn) {
+    if (tlb.num_sets == 0) return;
+
+    TLBEntry* set = &tlb.entries[tlbSetIndex(pid, vpn) * tlb.ways];
+    for (int way = 0; way < tlb.ways; way++) {
+        if (set[way].is_valid && set[way].vpn == vpn && set[way].pid == pid && !set[way].is_huge) {
+            set[way].is_valid = false;
+        }
+    }
+    if (tlb.huge_entries > 0) {
+        long long hugeVpn = vpn >> HUGE_PAGE_ORDER;
+        set = &tlb.entries[tlbSetIndex(pid, hugeVpn) * tlb.ways];
+        for (int way = 0; way < tlb.ways; way++) {
+            if (set[way].is_valid && set[way].vpn == hugeVpn && set[way].pid == pid && set[way].is_huge) {
+                tlbDropEntry(&set[way]);
+            }
+        }
+    }
+}
+
+// Function to drop every translation of a process from the TLB
+void tlbInvalidateProcess(int pid) {
+    for (int i = 0; i < tlb.num_sets * tlb.ways; i++) {
+        if (tlb.entries[i].pid == pid) {
+            tlbDropEntry(&tlb.entries[i]);
+        }
+    }
+}
+
+// Function to drop every translation from the TLB
+void tlbFlush(void) {
+    for (int i = 0; i < tlb.num_sets * tlb.ways; i++) {
+        tlb.entries[i].is_valid = false;
+    }
+    tlb.huge_entries = 0;
+}
+
+// Function to get the TLB and its counters
+const TLB* getTLB(void) {
+    return &tlb;
+}
@@ -0,0 +1,118 @@
+#include <stdbool.h> // For bool type
+#include "memory_config.h"
+
+#ifndef TLB_H
+#define TLB_H
+
+// Protection bits cached with a translation, checked on a hit like the PageTableEntry's on a walk
+#define TLB_PROT_READ 0x1
+#define TLB_PROT_WRITE 0x2
+#define TLB_PROT_EXEC 0x4
+
+// Define the TLBEntry structure
+typedef struct TLBEntry {
+    int pid;        // Process (address space) the translation belongs to
+    long long vpn;  // Per-process virtual page number, or huge page number (vpn >> HUGE_PAGE_ORDER) of a huge entry
+    int frame_num;  // Frame the page is mapped to, or the first frame of a huge page
+    bool is_valid;  // Indicates if the entry holds a translation
+    bool is_huge;   // The entry translates a whole huge page
+    unsigned char prot; // TLB_PROT_* bits the page allows
+} TLBEntry;
+
+// Define the TLB structure, a set-associative cache of page table translations
+typedef struct TLB {
+    TLBEntry* entries;      // num_sets * ways entries, one set after another
+    int* next_victim;       // Round-robin replacement pointer of each set
+    int num_sets;           // Number of sets, a power of two
+    int ways;               // Entries per set (associativity)
+    bool asid_tagged;       // Entries are tagged with the process ID, so switching processes needs no flush
+    int current_pid;        // Address space held by an untagged TLB, -1 if empty
+    int huge_entries;       // Valid huge-page entries; a lookup only probes for a huge page while there are any
+    long long hits;         // Lookups answered by the TLB
+    long long misses;       // Lookups that fell through to the page table walk
+    long long flushes;      // Full flushes caused by switching address spaces in an untagged TLB
+} TLB;
+
+/**
+ * initializeTLB function sets up the software TLB in front of the translation path.
+ * numEntries is rounded down to a multiple of ways, and the resulting number of sets to a power of two.
+ * Any previously initialized TLB is released first. Returns 0 on success, -1 on invalid sizes or allocation failure.
+
+   Parameters:
+   - numEntries: Total number of TLB entries.
+   - ways: Associativity; ways == numEntries gives a fully associative TLB, 1 a direct-mapped one.
+   - asidTagged: true to tag entries with the process ID, false to flush whenever the process changes.
+**/
+int initializeTLB(int numEntries, int ways, bool asidTagged);
+
+/**
+ * freeTLB function releases the TLB's entries. Lookups on a freed TLB always miss.
+**/
+void freeTLB(void);
+
+/**
+ * tlbLookup function returns the frame cached for (pid, vpn), or -1 on a miss, and counts the hit or miss.
+ * A page without an entry of its own is also found through the entry of the huge page covering it, if cached.
+ * In an untagged TLB a lookup for a different process than the last one flushes the TLB first.
+
+   Parameters:
+   - pid: The ID of the process performing the access.
+   - vpn: The per-process virtual page number being accessed.
+   - prot: Set to the TLB_PROT_* bits cached with the translation on a hit, if not NULL.
+**/
+int tlbLookup(int pid, long long vpn, int* prot);
+
+/**
+ * tlbInsert function caches the translation (pid, vpn) -> frameNum after a page table walk,
+ * replacing the set's entries round-robin once the set is full.
+
+   Parameters:
+   - pid: The ID of the process the translation belongs to.
+   - vpn: The per-process virtual page number.
+   - frameNum: The frame the page is mapped to.
+   - prot: The TLB_PROT_* bits the page allows.
+**/
+void tlbInsert(int pid, long long vpn, int frameNum, int prot);
+
+/**
+ * tlbInsertHuge function caches the translation of the whole huge page containing vpn with a single entry,
+ * so every page of the huge page hits in the TLB.
+
+   Parameters:
+   - pid: The ID of the process the translation belongs to.
+   - vpn: Any per-process virtual page number within the huge page.
+   - firstFrame: The first of the huge page's 2^HUGE_PAGE_ORDER contiguous frames.
+   - prot: The TLB_PROT_* bits the huge page allows.
+**/
+void tlbInsertHuge(int pid, long long vpn, int firstFrame, int prot);
+
+/**
+ * tlbInvalidatePage function drops the cached translation of a single page, if present,
+ * along with the entry of the huge page covering it. It must be called whenever the page is unmapped or remapped,
+ * or its protection changes.
+
+   Parameters:
+   - pid: The ID of the process the page belongs to.
+   - vpn: The per-process virtual page number.
+**/
+void tlbInvalidatePage(int pid, long long vpn);
+
+/**
+ * tlbInvalidateProcess function drops every cached translation of a process.
+
+   Parameters:
+   - pid: The ID of the process whose translations are dropped.
+**/
+void tlbInvalidateProcess(int pid);
+
+/**
+ * tlbFlush function drops every cached translation.
+**/
+void tlbFlush(void);
+
+/**
+ * getTLB function returns the TLB, e.g. to read its hit and miss counters.
+**/
+const TLB* getTLB(void);
+
+#endif // TLB_H
@@ -0,0 +1,286 @@
+#include <stdio.h>      // For file input and output
+#include <stdlib.h>     // For dynamic memory allocation
+#include <string.h>     // For string manipulation
+#include <time.h>       // For clock_gettime
+#include <fcntl.h>      // For open
+#include <unistd.h>     // For close
+#include <sys/mman.h>   // For mmap
+#include <sys/stat.h>   // For fstat
+#include "trace_replay.h"
+#include "process_table.h"
+
+
+// Handle of the last process looked up, since consecutive records usually come from the same process
+static int lastPid = -1;
+static ProcessHandle lastHandle = PROCESS_HANDLE_NONE;
+
+
+// Function to create a process listed in a trace header and register it in the process table. A process that
+// already exists with the same size, e.g. one of a loaded state image, is used as it is.
+static int createTraceProcess(int pid, long long memorySize, VirtualMemory* vm, PhysicalMemory* pm) {
+    Process* existing = findProcessById(pid);
+    if (existing != NULL && existing->memory_size == memorySize) return 0;
+    if (existing != NULL) {
+        fprintf(stderr, "Cannot create trace process %d: it already exists with %lld bytes.\n", pid, existing->memory_size);
+        return -1;
+    }
+    Process* process = create_process(pid, memorySize, vm);
+    if (process == NULL) {
+        fprintf(stderr, "Cannot create trace process %d with %lld bytes.\n", pid, memorySize);
+        return -1;
+    }
+    if (registerProcess(process).slot == -1) {
+        fprintf(stderr, "Cannot register trace process %d.\n", pid);
+        discard_process(process, vm, pm);
+        return -1;
+    }
+    return 0;
+}
+
+// Function to stream a single access record through the access path
+static void replayAccess(int pid, long long page, int offset, char op, PhysicalMemory* pm, ReplayStats* stats) {
+    Process* process = lookupProcess(lastHandle);
+    if (process == NULL || lastPid != pid) {
+        lastPid = pid;
+        lastHandle = findProcessHandle(pid);
+        process = lookupProcess(lastHandle);
+    }
+    if (process == NULL || offset < 0 || offset >= pm->config.page_size || (op != 'r' && op != 'w')) {
+        stats->invalid++;
+        return;
+    }
+
+    int result = accessMemory(process, page, op == 'w', pm);
+    if (result == ACCESS_INVALID_PAGE) {
+        stats->invalid++;
+        return;
+    }
+    if (result == ACCESS_PROTECTION) {
+        stats->denied++;
+        return;
+    }
+    if (result == ACCESS_NO_FRAME) {
+        stats->unresolved++;
+        return;
+    }
+    if (op == 'w') {
+        stats->writes++;
+    } else {
+        stats->reads++;
+    }
+    stats->accesses++;
+}
+
+// Function to read the next non-blank, non-comment line of a text trace
+static char* readTraceLine(char* line, int size, FILE* file) {
+    while (fgets(line, size, file) != NULL) {
+        char* start = line;
+        while (*start == ' ' || *start == '\t') start++;
+        if (*start != '\0' && *start != '\n' && *start != '#') return start;
+    }
+    return NULL;
+}
+
+// Function to parse an access line "<pid> <page> <offset> [r|w]"
+static int parseAccessLine(const char* line, TraceAccessRecord* record) {
+    char op = 'r';
+    int pid, offset;
+    long long page;
+    int fields = sscanf(line, "%d %lld %d %c", &pid, &page, &offset, &op);
+    if (fields < 3) return -1;
+
+    memset(record, 0, sizeof(TraceAccessRecord));
+    record->pid = pid;
+    record->page = page;
+    record->offset = offset >= 0 ? (uint32_t)offset : UINT32_MAX; // Page sizes are ints, so offsets up to INT_MAX fit
+    record->op = op;
+    return 0;
+}
+
+// Function to replay a text trace
+static int replayTextTrace(FILE* file, VirtualMemory* vm, PhysicalMemory* pm, ReplayStats* stats) {
+    char buffer[256];
+    char* line;
+    int lineNumber = 0;
+    struct timespec start, end;
+
+    // Header section: processes to create
+    while ((line = readTraceLine(buffer, sizeof(buffer), file)) != NULL) {
+        lineNumber++;
+        int pid;
+        long long memorySize;
+        if (strncmp(line, "process", 7) != 0) break;
+        if (sscanf(line + 7, "%d %lld", &pid, &memorySize) != 2) {
+            fprintf(stderr, "Malformed process line %d in trace.\n", lineNumber);
+            return -1;
+        }
+        if (createTraceProcess(pid, memorySize, vm, pm) != 0) return -1;
+    }
+
+    // Access records
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    while (line != NULL) {
+        TraceAccessRecord record;
+        if (parseAccessLine(line, &record) != 0) {
+            fprintf(stderr, "Malformed access line %d in trace.\n", lineNumber);
+            return -1;
+        }
+        replayAccess(record.pid, record.page, record.offset > INT32_MAX ? -1 : (int)record.offset, record.op, pm, stats);
+
+        line = readTraceLine(buffer, sizeof(buffer), file);
+        lineNumber++;
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+
+    stats->elapsed_seconds = (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9;
+    return 0;
+}
+
+// Function to replay a binary trace mapped into memory
+static int replayBinaryTrace(const char* data, size_t size, VirtualMemory* vm, PhysicalMemory* pm, ReplayStats* stats) {
+    const TraceFileHeader* header = (const TraceFileHeader*)data;
+    struct timespec start, end;
+
+    if (size < sizeof(TraceFileHeader) || header->version != TRACE_VERSION
+        || size != sizeof(TraceFileHeader) + header->process_count * sizeof(TraceProcessRecord)
+                                           + header->access_count * sizeof(TraceAccessRecord)) {
+        fprintf(stderr, "Malformed binary trace.\n");
+        return -1;
+    }
+
+    const TraceProcessRecord* processRecords = (const TraceProcessRecord*)(header + 1);
+    const TraceAccessRecord* accessRecords = (const TraceAccessRecord*)(processRecords + header->process_count);
+
+    for (uint32_t i = 0; i < header->process_count; i++) {
+        if (createTraceProcess(processRecords[i].pid, processRecords[i].memory_size, vm, pm) != 0) return -1;
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (uint64_t i = 0; i < header->access_count; i++) {
+        const TraceAccessRecord* record = &accessRecords[i];
+        replayAccess(record->pid, record->page, record->offset > INT32_MAX ? -1 : (int)record->offset, record->op, pm, stats);
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+
+    stats->elapsed_seconds = (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9;
+    return 0;
+}
+
+// Function to replay a text or binary trace
+int replayTrace(const char* path, VirtualMemory* vm, PhysicalMemory* pm, ReplayStats* stats) {
+    memset(stats, 0, sizeof(ReplayStats));
+    lastPid = -1;
+    lastHandle = PROCESS_HANDLE_NONE;
+
+    int fd = open(path, O_RDONLY);
+    if (fd == -1) {
+        perror(path);
+        return -1;
+    }
+
+    struct stat st;
+    char magic[4] = { 0 };
+    if (fstat(fd, &st) == -1 || (st.st_size >= 4 && pread(fd, magic, sizeof(magic), 0) != sizeof(magic))) {
+        perror(path);
+        close(fd);
+        return -1;
+    }
+
+    int result;
+    if (memcmp(magic, TRACE_MAGIC, sizeof(magic)) == 0) {
+        // Binary trace: map it and stream the records straight out of the page cache
+        void* data = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        close(fd);
+        if (data == MAP_FAILED) {
+            perror(path);
+            return -1;
+        }
+        madvise(data, st.st_size, MADV_SEQUENTIAL);
+        result = replayBinaryTrace(data, st.st_size, vm, pm, stats);
+        munmap(data, st.st_size);
+    } else {
+        FILE* file = fdopen(fd, "r");
+        if (file == NULL) {
+            perror(path);
+            close(fd);
+            return -1;
+        }
+        result = replayTextTrace(file, vm, pm, stats);
+        fclose(file);
+    }
+    return result;
+}
+
+// Function to convert a text trace into the binary form
+int convertTextTrace(const char* textPath, const char* binaryPath) {
+    FILE* in = fopen(textPath, "r");
+    if (in == NULL) {
+        perror(textPath);
+        return -1;
+    }
+
+    TraceFileHeader header = { .version = TRACE_VERSION };
+    memcpy(header.magic, TRACE_MAGIC, sizeof(header.magic));
+    int processCapacity = 16;
+    long long accessCapacity = 1024;
+    TraceProcessRecord* processRecords = malloc(processCapacity * sizeof(TraceProcessRecord));
+    TraceAccessRecord* accessRecords = malloc(accessCapacity * sizeof(TraceAccessRecord));
+    int result = -1;
+
+    char buffer[256];
+    char* line;
+    while (processRecords && accessRecords && (line = readTraceLine(buffer, sizeof(buffer), in)) != NULL) {
+        if (strncmp(line, "process", 7) == 0) {
+            if (header.access_count > 0) {
+                fprintf(stderr, "Process line after access records in %s.\n", textPath);
+                goto done;
+            }
+            if (header.process_count == (uint32_t)processCapacity) {
+                TraceProcessRecord* grown = realloc(processRecords, 2 * processCapacity * sizeof(TraceProcessRecord));
+                if (!grown) goto done;
+                processRecords = grown;
+                processCapacity *= 2;
+            }
+            TraceProcessRecord* record = &processRecords[header.process_count];
+            long long memorySize;
+            if (sscanf(line + 7, "%d %lld", &record->pid, &memorySize) != 2) {
+                fprintf(stderr, "Malformed process line in %s.\n", textPath);
+                goto done;
+            }
+            record->reserved = 0;
+            record->memory_size = memorySize;
+            header.process_count++;
+        } else {
+            if (header.access_count == (uint64_t)accessCapacity) {
+                TraceAccessRecord* grown = realloc(accessRecords, 2 * accessCapacity * sizeof(TraceAccessRecord));
+                if (!grown) goto done;
+                accessRecords = grown;
+                accessCapacity *= 2;
+            }
+            if (parseAccessLine(line, &accessRecords[header.access_count]) != 0) {
+                fprintf(stderr, "Malformed access line in %s.\n", textPath);
+                goto done;
+            }
+            header.access_count++;
+        }
+    }
+    if (!processRecords || !accessRecords) goto done;
+
+    FILE* out = fopen(binaryPath, "wb");
+    if (out == NULL) {
+        perror(binaryPath);
+        goto done;
+    }
+    if (fwrite(&header, sizeof(header), 1, out) == 1
+        && fwrite(processRecords, sizeof(TraceProcessRecord), header.process_count, out) == header.process_count
+        && fwrite(accessRecords, sizeof(TraceAccessRecord), header.access_count, out) == header.access_count) {
+        result = 0;
+    }
+    if (fclose(out) != 0) result = -1;
+
+done:
+    free(processRecords);
+    free(accessRecords);
+    fclose(in);
+    return result;
+}
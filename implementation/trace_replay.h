@@ -0,0 +1,79 @@
+#include <stdint.h> // For fixed-width record fields
+#include "page_table.h"
+
+#ifndef TRACE_REPLAY_H
+#define TRACE_REPLAY_H
+
+/**
+ * Access traces come in two forms.
+ *
+ * Text traces start with a header section of "process <pid> <memory_size>" lines, one per process to create,
+ * followed by one access per line: "<pid> <page> <offset> [r|w]", where page is the process's own page number
+ * and the operation defaults to r. Blank lines and lines starting with '#' are ignored.
+ *
+ * Binary traces are a TraceFileHeader, header.process_count TraceProcessRecords and header.access_count
+ * TraceAccessRecords, in native byte order. They are read through mmap, and convertTextTrace produces them.
+**/
+
+#define TRACE_MAGIC "PGTR"
+#define TRACE_VERSION 3
+
+typedef struct TraceFileHeader {
+    char magic[4];              // TRACE_MAGIC
+    uint32_t version;           // TRACE_VERSION
+    uint32_t process_count;     // Number of TraceProcessRecords after the header
+    uint32_t reserved;
+    uint64_t access_count;      // Number of TraceAccessRecords after the process records
+} TraceFileHeader;
+
+typedef struct TraceProcessRecord {
+    int32_t pid;
+    int32_t reserved;
+    int64_t memory_size;        // Bytes of virtual memory to create the process with
+} TraceProcessRecord;
+
+typedef struct TraceAccessRecord {
+    int64_t page;               // Per-process virtual page number
+    int32_t pid;
+    uint32_t offset;            // Offset within the page, UINT32_MAX for one out of range
+    uint8_t op;                 // 'r' or 'w'
+    uint8_t reserved[7];
+} TraceAccessRecord;
+
+// Define the ReplayStats structure, filled in by replayTrace
+typedef struct ReplayStats {
+    long long accesses;         // Records that accessMemory completed
+    long long reads;            // Completed records with the 'r' operation
+    long long writes;           // Completed records with the 'w' operation
+    long long invalid;          // Records naming an unknown process, page or offset
+    long long denied;           // Records the page's protection does not allow (ACCESS_PROTECTION)
+    long long unresolved;       // Records whose page fault found no frame (ACCESS_NO_FRAME)
+    double elapsed_seconds;     // Time spent streaming records, excluding process creation
+} ReplayStats;
+
+/**
+ * replayTrace function replays an access trace (text or binary, detected from the first bytes of the file).
+ * It creates the processes listed in the header section, then streams every access record through
+ * accessMemory, so page faults, evictions and TLB lookups behave exactly as in interactive use. A listed process
+ * that already exists (e.g. from a loaded state image) is reused if it has the listed size.
+ * Returns 0 on success, or -1 if the file cannot be read, is malformed, or a process cannot be created (or exists
+ * with a different size).
+
+   Parameters:
+   - path: The path of the trace file.
+   - vm: A pointer to the VirtualMemory structure.
+   - pm: A pointer to the PhysicalMemory structure.
+   - stats: Filled in with the replay counters and timing.
+**/
+int replayTrace(const char* path, VirtualMemory* vm, PhysicalMemory* pm, ReplayStats* stats);
+
+/**
+ * convertTextTrace function converts a text trace into the binary form. Returns 0 on success, -1 on error.
+
+   Parameters:
+   - textPath: The path of the text trace to read.
+   - binaryPath: The path of the binary trace to write.
+**/
+int convertTextTrace(const char* textPath, const char* binaryPath);
+
+#endif // TRACE_REPLAY_H
@@ -1,25 +1,34 @@
+#include <stdint.h> // For uint64_t bitmap words
+#include <stdbool.h> // For bool type
 #include "memory_config.h"
 
 #ifndef VIRTUAL_MEMORY_H
 #define VIRTUAL_MEMORY_H
 
-// Define the Chunk structure
-typedef struct Chunk {
-    int offset;         // Offset within the page, from 0 to PAGE_SIZE - 1
-    int is_allocated;   // 1 if the chunk is allocated, 0 otherwise
-} Chunk;
+// Bitmap geometry: one bit per page
+#define PAGE_BITMAP_WORDS(count) (((count) + 63) / 64)
 
-// Define the Page structure
-typedef struct Page {
-    int id;                         // Page identifier
-    Chunk chunks[PAGE_SIZE / KB];   // Array of chunks within the page
-    int is_allocated;               // 1 if all chunks in the page are allocated, 0 otherwise
-} Page;
+// Number of pages the VirtualMemory metadata arrays are first sized for; they double as pages are handed out
+#define VIRTUAL_MEMORY_INITIAL_CAPACITY 4096
 
-// Define the VirtualMemory structure
+/**
+ * Define the VirtualMemory structure.
+ * Page metadata is kept as dense arrays rather than an array of per-page structures: a page's ID is its index,
+ * its allocation state is a bit, its chunks in use are a byte (bit j for chunk j, at offset j * chunk_size).
+ * Page IDs are handed out from next_page upwards (after reusing freed ones), so the arrays only have to cover
+ * pages below next_page and grow on demand: their size follows the pages actually handed out, not the size
+ * of the virtual address space.
+**/
 typedef struct VirtualMemory {
-    Page pages[NUM_PAGES];          // Array of pages in virtual memory
-    int remaining_memory;           // Remaining memory in virtual memory
+    MemoryConfig config;            // Geometry of the memory system
+    uint64_t* allocated_pages;      // Bit i is set while page i is allocated
+    uint8_t* allocated_chunks;      // Chunk mask of each page
+    long long* free_pages;          // Stack of freed page IDs, reused before untouched pages
+    long long free_count;           // Number of page IDs on the free stack
+    long long next_page;            // Pages from next_page up have never been allocated
+    long long capacity;             // Number of pages the arrays above cover
+    long long remaining_memory;     // Remaining memory in virtual memory
+    bool mapped;                    // The arrays live in a loaded state image (see snapshot.h): they are moved to the heap before they grow, and never freed
 } VirtualMemory;
 
-#endif // VIRTUAL_MEMORY_H
\ No newline at end of file
+#endif // VIRTUAL_MEMORY_H